@@ -0,0 +1,99 @@
+#include "benchmark_framework.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+
+namespace {
+
+void PrintJsonString(std::ostream &output, const std::string &text) {
+    output << '"';
+    for (const char kChar: text) {
+        if (kChar == '"' || kChar == '\\') {
+            output << '\\';
+        }
+        output << kChar;
+    }
+    output << '"';
+}
+
+}
+
+BenchmarkRunner::BenchmarkRunner(BenchmarkOptions options)
+        : options_(std::move(options)) {
+}
+
+void BenchmarkRunner::AddContext(std::string key, std::string value) {
+    context_.emplace_back(std::move(key), std::move(value));
+}
+
+const std::vector<BenchmarkResult> &BenchmarkRunner::GetResults() const {
+    return results_;
+}
+
+void BenchmarkRunner::PrintTable(std::ostream &output) const {
+    output << std::left << std::setw(40) << "benchmark" << std::right << std::setw(12) << "iterations"
+           << std::setw(14) << "median ns" << std::setw(14) << "mean ns" << std::setw(12) << "stddev %"
+           << std::setw(14) << "min ns" << std::setw(14) << "max ns" << '\n';
+    output << std::fixed << std::setprecision(1);
+    for (const BenchmarkResult &result: results_) {
+        const double kRelativeStddev = result.mean_ns > 0.0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0;
+        output << std::left << std::setw(40) << result.name << std::right << std::setw(12) << result.iterations
+               << std::setw(14) << result.median_ns << std::setw(14) << result.mean_ns << std::setw(12)
+               << kRelativeStddev << std::setw(14) << result.min_ns << std::setw(14) << result.max_ns << '\n';
+    }
+    output << std::defaultfloat << std::flush;
+}
+
+void BenchmarkRunner::PrintJson(std::ostream &output) const {
+    output << "{\n  \"context\": {\"warmup_repetitions\": " << options_.warmup_repetitions
+           << ", \"repetitions\": " << options_.repetitions;
+    for (const auto &[key, value]: context_) {
+        output << ", ";
+        PrintJsonString(output, key);
+        output << ": ";
+        PrintJsonString(output, value);
+    }
+    output << "},\n  \"benchmarks\": [";
+    for (size_t i = 0U; i < results_.size(); ++i) {
+        const BenchmarkResult &kResult = results_[i];
+        output << (i == 0U ? "\n" : ",\n") << "    {\"name\": ";
+        PrintJsonString(output, kResult.name);
+        output << ", \"iterations\": " << kResult.iterations << ", \"repetitions\": " << kResult.repetitions
+               << ", \"median_ns\": " << kResult.median_ns << ", \"mean_ns\": " << kResult.mean_ns
+               << ", \"stddev_ns\": " << kResult.stddev_ns << ", \"min_ns\": " << kResult.min_ns
+               << ", \"max_ns\": " << kResult.max_ns << "}";
+    }
+    output << "\n  ]\n}" << std::endl;
+}
+
+bool BenchmarkRunner::IsSelected(const std::string &name) const {
+    return name.find(options_.filter) != std::string::npos;
+}
+
+void BenchmarkRunner::AddResult(const std::string &name, size_t iterations, std::vector<double> samples) {
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = samples.size();
+    if (samples.empty()) {
+        results_.push_back(result);
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const size_t kMiddle = samples.size() / 2U;
+    result.median_ns = samples.size() % 2U == 1U ? samples[kMiddle] : (samples[kMiddle - 1U] + samples[kMiddle]) / 2.0;
+    result.mean_ns = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    double squared_deviations = 0.0;
+    for (const double kSample: samples) {
+        squared_deviations += (kSample - result.mean_ns) * (kSample - result.mean_ns);
+    }
+    result.stddev_ns = samples.size() > 1U ? std::sqrt(squared_deviations / static_cast<double>(samples.size() - 1U))
+                                           : 0.0;
+    result.min_ns = samples.front();
+    result.max_ns = samples.back();
+    results_.push_back(result);
+}
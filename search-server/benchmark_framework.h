@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchmarkOptions {
+    // untimed repetitions that warm caches, the allocator and the branch predictor
+    size_t warmup_repetitions = 1U;
+    size_t repetitions = 10U;
+    // only benchmarks whose name contains it run, all of them if empty
+    std::string filter;
+};
+
+// Nanoseconds per iteration, summarized over the timed repetitions
+struct BenchmarkResult {
+    std::string name;
+    size_t iterations = 0U;
+    size_t repetitions = 0U;
+    double mean_ns = 0.0;
+    double median_ns = 0.0;
+    double stddev_ns = 0.0;
+    double min_ns = 0.0;
+    double max_ns = 0.0;
+};
+
+// Keeps the compiler from dropping a computation whose result is never used
+template<typename T>
+void DoNotOptimize(const T &value) {
+    __asm__ __volatile__("" : : "g"(&value) : "memory");
+}
+
+class BenchmarkRunner {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit BenchmarkRunner(BenchmarkOptions options);
+
+public:
+    // Times iterations calls of body(i) per repetition
+    template<typename Body>
+    void Run(const std::string &name, size_t iterations, Body body);
+
+    // setup() runs untimed before every repetition, its result is passed to every body(state, i) call of it
+    template<typename Setup, typename Body>
+    void Run(const std::string &name, size_t iterations, Setup setup, Body body);
+
+    // Extra key-value pairs written to the JSON context, such as the corpus size and seed
+    void AddContext(std::string key, std::string value);
+
+    const std::vector<BenchmarkResult> &GetResults() const;
+
+    void PrintTable(std::ostream &output) const;
+
+    void PrintJson(std::ostream &output) const;
+
+private:
+    bool IsSelected(const std::string &name) const;
+
+    void AddResult(const std::string &name, size_t iterations, std::vector<double> samples);
+
+private:
+    const BenchmarkOptions options_;
+    std::vector<std::pair<std::string, std::string>> context_;
+    std::vector<BenchmarkResult> results_;
+};
+
+template<typename Body>
+void BenchmarkRunner::Run(const std::string &name, size_t iterations, Body body) {
+    Run(name, iterations, []() { return 0; }, [&body](int, size_t i) { body(i); });
+}
+
+template<typename Setup, typename Body>
+void BenchmarkRunner::Run(const std::string &name, size_t iterations, Setup setup, Body body) {
+    if (!IsSelected(name) || iterations == 0U) {
+        return;
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options_.repetitions);
+    for (size_t repetition = 0U; repetition < options_.warmup_repetitions + options_.repetitions; ++repetition) {
+        auto state = setup();
+        const auto kStartTime = Clock::now();
+        for (size_t i = 0U; i < iterations; ++i) {
+            body(state, i);
+        }
+        const auto kElapsed = Clock::now() - kStartTime;
+        if (repetition >= options_.warmup_repetitions) {
+            samples.push_back(std::chrono::duration<double, std::nano>(kElapsed).count() /
+                              static_cast<double>(iterations));
+        }
+    }
+    AddResult(name, iterations, std::move(samples));
+}
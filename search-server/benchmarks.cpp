@@ -0,0 +1,222 @@
+#include "benchmark_framework.h"
+#include "paginator.h"
+#include "profiler.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "string_processing.h"
+#include "workload_generator.h"
+
+#include <fstream>
+#include <iostream>
+
+
+namespace {
+
+using namespace std::string_literals;
+
+struct BenchmarkConfig {
+    BenchmarkOptions options;
+    WorkloadOptions workload;
+    size_t document_count = 20000U;
+    size_t query_count = 1000U;
+    std::string json_path;
+    bool profile = false;
+};
+
+// Seeded corpus, equal seeds give equal corpora on a given platform
+struct BenchmarkCorpus {
+    std::string stop_words;
+    std::vector<GeneratedDocument> documents;
+    std::vector<std::string> narrow_queries;
+    std::vector<std::string> broad_queries;
+    std::vector<std::string> minus_heavy_queries;
+};
+
+// Broad queries follow the corpus distribution and hit the head words, narrow ones are uniform over the vocabulary
+// and so mostly hit the long tail
+BenchmarkCorpus MakeCorpus(const BenchmarkConfig &config) {
+    WorkloadGenerator document_generator(config.workload);
+
+    WorkloadOptions narrow_options = config.workload;
+    narrow_options.seed += 1U;
+    narrow_options.zipf_exponent = 0.0;
+    narrow_options.min_query_length = 2U;
+    narrow_options.max_query_length = 2U;
+    narrow_options.minus_word_ratio = 0.0;
+    WorkloadGenerator narrow_generator(narrow_options);
+
+    WorkloadOptions broad_options = config.workload;
+    broad_options.seed += 2U;
+    broad_options.min_query_length = 3U;
+    broad_options.max_query_length = 3U;
+    broad_options.minus_word_ratio = 0.0;
+    WorkloadGenerator broad_generator(broad_options);
+
+    WorkloadOptions minus_heavy_options = broad_options;
+    minus_heavy_options.seed += 3U;
+    minus_heavy_options.min_query_length = 9U;
+    minus_heavy_options.max_query_length = 9U;
+    minus_heavy_options.minus_word_ratio = 1.0;
+    WorkloadGenerator minus_heavy_generator(minus_heavy_options);
+
+    return {document_generator.GetStopWords(), document_generator.GenerateDocuments(config.document_count),
+            narrow_generator.GenerateQueries(config.query_count), broad_generator.GenerateQueries(config.query_count),
+            minus_heavy_generator.GenerateQueries(config.query_count)};
+}
+
+// Ids are positions in documents
+SearchServer BuildServer(const std::string &stop_words, const std::vector<GeneratedDocument> &documents) {
+    SearchServer server(stop_words);
+    for (size_t i = 0U; i < documents.size(); ++i) {
+        server.AddDocument(static_cast<int>(i), documents[i].text, documents[i].status, documents[i].ratings);
+    }
+    return server;
+}
+
+void RunBenchmarks(BenchmarkRunner &runner, const BenchmarkCorpus &corpus) {
+    const auto &kStopWords = corpus.stop_words;
+    const auto &kDocuments = corpus.documents;
+
+    runner.Run("SplitIntoWords"s, kDocuments.size(), [&kDocuments](size_t i) {
+        DoNotOptimize(SplitIntoWords(kDocuments[i].text));
+    });
+
+    runner.Run("AddDocument"s, kDocuments.size(), [&kStopWords]() { return SearchServer(kStopWords); },
+               [&kDocuments](SearchServer &server, size_t i) {
+                   server.AddDocument(static_cast<int>(i), kDocuments[i].text, kDocuments[i].status,
+                                      kDocuments[i].ratings);
+               });
+
+    const SearchServer kServer = BuildServer(kStopWords, kDocuments);
+    const auto kFindBenchmark = [&runner, &kServer](const std::string &name, const std::vector<std::string> &queries) {
+        runner.Run(name, queries.size(), [&kServer, &queries](size_t i) {
+            DoNotOptimize(kServer.FindTopDocuments(queries[i]));
+        });
+    };
+    kFindBenchmark("FindTopDocuments/narrow"s, corpus.narrow_queries);
+    kFindBenchmark("FindTopDocuments/broad"s, corpus.broad_queries);
+    kFindBenchmark("FindTopDocuments/minus_heavy"s, corpus.minus_heavy_queries);
+
+    const auto &kQueries = corpus.broad_queries;
+    runner.Run("MatchDocument"s, kQueries.size(), [&kServer, &kQueries, &kDocuments](size_t i) {
+        DoNotOptimize(kServer.MatchDocument(kQueries[i], static_cast<int>(i * 7919U % kDocuments.size())));
+    });
+    runner.Run("MatchDocument/par"s, kQueries.size(), [&kServer, &kQueries, &kDocuments](size_t i) {
+        DoNotOptimize(kServer.MatchDocument(std::execution::par, kQueries[i],
+                                            static_cast<int>(i * 7919U % kDocuments.size())));
+    });
+
+    runner.Run("RemoveDocument"s, kDocuments.size(),
+               [&kStopWords, &kDocuments]() { return BuildServer(kStopWords, kDocuments); },
+               [](SearchServer &server, size_t i) { server.RemoveDocument(static_cast<int>(i)); });
+
+    // every document appears twice under different ids
+    std::vector<GeneratedDocument> duplicated_documents(kDocuments.begin(),
+                                                        kDocuments.begin() + kDocuments.size() / 2U);
+    duplicated_documents.insert(duplicated_documents.end(), duplicated_documents.begin(), duplicated_documents.end());
+    const auto kBuildDuplicated = [&kStopWords, &duplicated_documents]() {
+        return BuildServer(kStopWords, duplicated_documents);
+    };
+    runner.Run("RemoveDuplicates"s, 1U, kBuildDuplicated,
+               [](SearchServer &server, size_t) { DoNotOptimize(RemoveDuplicates(std::execution::seq, server)); });
+    runner.Run("RemoveDuplicates/par"s, 1U, kBuildDuplicated,
+               [](SearchServer &server, size_t) { DoNotOptimize(RemoveDuplicates(std::execution::par, server)); });
+
+    const std::vector<Document> kResults(1000000U, Document(1, 0.5, 3));
+    runner.Run("Paginator/walk"s, 1U, [&kResults](size_t) {
+        size_t pages = 0U;
+        for (const auto &page: Paginate(kResults, 10U)) {
+            pages += page.size();
+        }
+        DoNotOptimize(pages);
+    });
+    runner.Run("Paginator/random_access"s, 1000U, [&kResults](size_t i) {
+        const auto kPages = Paginate(kResults, 10U);
+        DoNotOptimize(kPages[i * 7919U % kPages.size()]);
+    });
+}
+
+void PrintUsage(const char *program) {
+    std::cerr << "Usage: " << program << " [--repetitions=N] [--warmup=N] [--filter=TEXT] [--documents=N]"
+              << " [--queries=N] [--seed=N] [--vocabulary=N] [--zipf=S] [--json=PATH]"
+              << " [--profile]\n";
+}
+
+// Returns false on an unknown or malformed argument
+bool ParseArguments(int argc, char *argv[], BenchmarkConfig &config) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string kArgument = argv[i];
+        if (kArgument == "--profile"s) {
+            config.profile = true;
+            continue;
+        }
+        const size_t kEquals = kArgument.find('=');
+        if (kEquals == std::string::npos) {
+            return false;
+        }
+        const std::string kName = kArgument.substr(0U, kEquals);
+        const std::string kValue = kArgument.substr(kEquals + 1U);
+        try {
+            if (kName == "--repetitions"s) {
+                config.options.repetitions = std::stoul(kValue);
+            } else if (kName == "--warmup"s) {
+                config.options.warmup_repetitions = std::stoul(kValue);
+            } else if (kName == "--filter"s) {
+                config.options.filter = kValue;
+            } else if (kName == "--documents"s) {
+                config.document_count = std::stoul(kValue);
+            } else if (kName == "--queries"s) {
+                config.query_count = std::stoul(kValue);
+            } else if (kName == "--seed"s) {
+                config.workload.seed = std::stoull(kValue);
+            } else if (kName == "--vocabulary"s) {
+                config.workload.vocabulary_size = std::stoul(kValue);
+            } else if (kName == "--zipf"s) {
+                config.workload.zipf_exponent = std::stod(kValue);
+            } else if (kName == "--json"s) {
+                config.json_path = kValue;
+            } else {
+                return false;
+            }
+        } catch (const std::logic_error &) {
+            return false;
+        }
+    }
+    return config.document_count > 0U && config.workload.vocabulary_size > 0U && config.workload.zipf_exponent >= 0.0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    BenchmarkConfig config;
+    if (!ParseArguments(argc, argv, config)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const BenchmarkCorpus kCorpus = MakeCorpus(config);
+    BenchmarkRunner runner(config.options);
+    runner.AddContext("documents"s, std::to_string(config.document_count));
+    runner.AddContext("queries"s, std::to_string(config.query_count));
+    runner.AddContext("seed"s, std::to_string(config.workload.seed));
+    runner.AddContext("vocabulary"s, std::to_string(config.workload.vocabulary_size));
+    runner.AddContext("zipf_exponent"s, std::to_string(config.workload.zipf_exponent));
+    // scopes inside the search server are timed too, which slows the benchmarks themselves down a little
+    Profiler::GetInstance().SetEnabled(config.profile);
+    RunBenchmarks(runner, kCorpus);
+    runner.PrintTable(std::cout);
+    if (config.profile) {
+        std::cout << '\n';
+        Profiler::PrintSnapshot(Profiler::GetInstance().GetSnapshot(), std::cout);
+    }
+
+    if (!config.json_path.empty()) {
+        std::ofstream json(config.json_path);
+        runner.PrintJson(json);
+        if (!json) {
+            std::cerr << "Cannot write " << config.json_path << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Blocking FIFO of at most capacity items joining two pipeline stages. Closing wakes everybody up:
+// producers stop pushing, consumers drain what is left.
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity);
+
+public:
+    // Waits for free space, returns false if the queue is closed
+    bool Push(T value);
+
+    // Waits for an item, nullopt once the queue is closed and empty
+    std::optional<T> Pop();
+
+    void Close();
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_;
+    bool is_closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity)
+        : capacity_(std::max<size_t>(capacity, 1U)) {
+}
+
+template<typename T>
+bool BoundedQueue<T>::Push(T value) {
+    std::unique_lock lock(mutex_);
+    not_full_.wait(lock, [this]() { return is_closed_ || items_.size() < capacity_; });
+    if (is_closed_) {
+        return false;
+    }
+    items_.push_back(std::move(value));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+template<typename T>
+std::optional<T> BoundedQueue<T>::Pop() {
+    std::unique_lock lock(mutex_);
+    not_empty_.wait(lock, [this]() { return is_closed_ || !items_.empty(); });
+    if (items_.empty()) {
+        return std::nullopt;
+    }
+    std::optional<T> value(std::move(items_.front()));
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return value;
+}
+
+template<typename T>
+void BoundedQueue<T>::Close() {
+    {
+        std::lock_guard lock(mutex_);
+        is_closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+}
@@ -0,0 +1,78 @@
+#include "concurrent_request_queue.h"
+
+namespace {
+
+const size_t kSlotsPerCacheLine = 64U / sizeof(std::atomic<uint64_t>);
+const uint64_t kCountMask = 0xffffffffULL;
+const unsigned kTickShift = 32U;
+
+// threads are numbered once, in the order they first record a request
+size_t GetThreadIndex() {
+    static std::atomic<size_t> next_index{0U};
+    thread_local const size_t kIndex = next_index.fetch_add(1U, std::memory_order_relaxed);
+    return kIndex;
+}
+
+}
+
+ConcurrentRequestQueue::ConcurrentRequestQueue(const SearchServer &search_server, Clock::duration window,
+                                               Clock::duration bucket, size_t shard_count,
+                                               Clock::time_point (*now)())
+        : search_server_(search_server),
+          ring_size_(RequestQueue::GetBucketCount(window, bucket)),
+          shard_stride_((ring_size_ + kSlotsPerCacheLine - 1U) / kSlotsPerCacheLine * kSlotsPerCacheLine +
+                        kSlotsPerCacheLine),
+          shard_count_(std::max<size_t>(shard_count, 1U)),
+          slots_(shard_stride_ * shard_count_),
+          bucket_duration_(bucket), now_(now), start_time_(now()) {
+
+}
+
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(const std::string &raw_query, DocumentStatus status) {
+    auto result = search_server_.FindTopDocuments(raw_query, status);
+    CollectMetrics(result);
+    return result;
+}
+
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(const std::string &raw_query) {
+    auto result = search_server_.FindTopDocuments(raw_query);
+    CollectMetrics(result);
+    return result;
+}
+
+int ConcurrentRequestQueue::GetNoResultRequests() const {
+    const uint64_t kTick = GetCurrentTick();
+
+    uint64_t empty_results = 0U;
+    for (size_t shard = 0U; shard < shard_count_; ++shard) {
+        for (size_t i = 0U; i < ring_size_; ++i) {
+            const uint64_t kSlot = slots_[shard * shard_stride_ + i].load(std::memory_order_relaxed);
+            const uint64_t kSlotTick = kSlot >> kTickShift;
+            if (kSlotTick <= kTick && kSlotTick + ring_size_ > kTick) {
+                empty_results += kSlot & kCountMask;
+            }
+        }
+    }
+    return static_cast<int>(empty_results);
+}
+
+void ConcurrentRequestQueue::CollectMetrics(const std::vector<Document> &result) {
+    if (!result.empty()) {
+        return;
+    }
+
+    const uint64_t kTick = GetCurrentTick();
+    const size_t kShard = GetThreadIndex() % shard_count_;
+    std::atomic<uint64_t> &slot = slots_[kShard * shard_stride_ + kTick % ring_size_];
+
+    // a slot still holding an older tick has left the window and starts over
+    uint64_t value = slot.load(std::memory_order_relaxed);
+    uint64_t updated;
+    do {
+        updated = (value >> kTickShift) == kTick ? value + 1U : (kTick << kTickShift) | 1U;
+    } while (!slot.compare_exchange_weak(value, updated, std::memory_order_relaxed));
+}
+
+uint64_t ConcurrentRequestQueue::GetCurrentTick() const {
+    return static_cast<uint64_t>((now_() - start_time_) / bucket_duration_);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "request_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// RequestQueue for many query threads over a wall-clock window. Every thread counts empty results in its own
+// shard of per-bucket counters, shards are summed on read. The request path takes no lock and, while there are
+// no more threads than shards, never writes to a cache line another thread writes to.
+class ConcurrentRequestQueue {
+public:
+    using Clock = RequestQueue::Clock;
+
+    // Throws std::invalid_argument unless window and bucket are positive
+    ConcurrentRequestQueue(const SearchServer &search_server, Clock::duration window, Clock::duration bucket,
+                           size_t shard_count = std::max(std::thread::hardware_concurrency(), 1U),
+                           Clock::time_point (*now)() = &Clock::now);
+
+public:
+    template<typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(const std::string &raw_query, DocumentPredicate document_predicate);
+
+    std::vector<Document> AddFindRequest(const std::string &raw_query, DocumentStatus status);
+
+    std::vector<Document> AddFindRequest(const std::string &raw_query);
+
+    int GetNoResultRequests() const;
+
+public:
+    void CollectMetrics(const std::vector<Document> &result);
+
+private:
+    uint64_t GetCurrentTick() const;
+
+private:
+    const SearchServer &search_server_;
+    const size_t ring_size_;
+    // shard rings are padded by a cache line, so neighbouring shards never share one
+    const size_t shard_stride_;
+    const size_t shard_count_;
+    // tick in the high half, empty result count of that tick in the low half
+    std::vector<std::atomic<uint64_t>> slots_;
+    const Clock::duration bucket_duration_;
+    Clock::time_point (*const now_)();
+    const Clock::time_point start_time_;
+};
+
+template<typename DocumentPredicate>
+std::vector<Document> ConcurrentRequestQueue::AddFindRequest(const std::string &raw_query,
+                                                             DocumentPredicate document_predicate) {
+    auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
+    CollectMetrics(result);
+    return result;
+}
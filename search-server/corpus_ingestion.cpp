@@ -0,0 +1,232 @@
+#include "corpus_ingestion.h"
+#include "bounded_queue.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LineBatch {
+    size_t first_line_number;
+    std::vector<std::string> lines;
+};
+
+// words of the records point into the lines
+struct TokenizedBatch {
+    std::vector<std::string> lines;
+    std::vector<TokenizedRecord> records;
+};
+
+std::invalid_argument MakeLineError(size_t line_number, const std::string &message) {
+    return std::invalid_argument("corpus line " + std::to_string(line_number) + ": " + message);
+}
+
+int ParseNumber(std::string_view field, size_t line_number) {
+    int value = 0;
+    const auto[kEnd, kError] = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (field.empty() || kError != std::errc() || kEnd != field.data() + field.size()) {
+        throw MakeLineError(line_number, "invalid number '" + std::string(field) + "'");
+    }
+    return value;
+}
+
+// Cuts the field up to the next tab off the line
+std::string_view TakeField(std::string_view &line, size_t line_number) {
+    const size_t kTab = line.find('\t');
+    if (kTab == std::string_view::npos) {
+        throw MakeLineError(line_number, "expected id, status, ratings and text separated by tabs");
+    }
+    const std::string_view kField = line.substr(0U, kTab);
+    line.remove_prefix(kTab + 1U);
+    return kField;
+}
+
+// Returns the bytes read, stops early once the tokenizer is gone
+size_t ReadLines(std::istream &input, const IngestionOptions &options, BoundedQueue<LineBatch> &lines) {
+    const size_t kBatchSize = std::max<size_t>(options.batch_size, 1U);
+    std::vector<char> buffer(std::max<size_t>(options.read_buffer_size, 1U));
+    std::string partial_line;
+    LineBatch batch{1U, {}};
+    size_t line_count = 0U;
+    size_t bytes = 0U;
+
+    while (input.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || input.gcount() > 0) {
+        const auto kReadSize = static_cast<size_t>(input.gcount());
+        bytes += kReadSize;
+
+        const char *first = buffer.data();
+        const char *const kLast = first + kReadSize;
+        for (const char *line_end = std::find(first, kLast, '\n'); line_end != kLast;
+             line_end = std::find(first, kLast, '\n')) {
+            partial_line.append(first, line_end);
+            batch.lines.push_back(std::move(partial_line));
+            partial_line.clear();
+            ++line_count;
+            first = line_end + 1;
+
+            if (batch.lines.size() == kBatchSize) {
+                if (!lines.Push(std::move(batch))) {
+                    return bytes;
+                }
+                batch = LineBatch{line_count + 1U, {}};
+            }
+        }
+        partial_line.append(first, kLast);
+    }
+    if (input.bad()) {
+        throw std::runtime_error("corpus read failed");
+    }
+
+    if (!partial_line.empty()) {
+        batch.lines.push_back(std::move(partial_line));
+    }
+    if (!batch.lines.empty()) {
+        lines.Push(std::move(batch));
+    }
+    return bytes;
+}
+
+void TokenizeLines(const SearchServer &search_server, BoundedQueue<LineBatch> &lines,
+                   BoundedQueue<TokenizedBatch> &documents) {
+    while (auto batch = lines.Pop()) {
+        // moving the vector keeps every string in place, so views into them stay valid
+        TokenizedBatch tokenized{std::move(batch->lines), {}};
+        tokenized.records.reserve(tokenized.lines.size());
+        for (size_t i = 0U; i < tokenized.lines.size(); ++i) {
+            if (tokenized.lines[i].empty()) {
+                continue;
+            }
+            tokenized.records.push_back(
+                    TokenizeCorpusLine(search_server, tokenized.lines[i], batch->first_line_number + i));
+        }
+        if (!documents.Push(std::move(tokenized))) {
+            return;
+        }
+    }
+}
+
+double ComputeRate(size_t documents, Clock::duration elapsed) {
+    const double kSeconds = std::chrono::duration<double>(elapsed).count();
+    return kSeconds > 0.0 ? static_cast<double>(documents) / kSeconds : 0.0;
+}
+
+}
+
+CorpusRecord ParseCorpusLine(std::string_view line, size_t line_number) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1U);
+    }
+
+    CorpusRecord record;
+    record.id = ParseNumber(TakeField(line, line_number), line_number);
+
+    const int kStatus = ParseNumber(TakeField(line, line_number), line_number);
+    if (kStatus < static_cast<int>(DocumentStatus::ACTUAL) || kStatus > static_cast<int>(DocumentStatus::REMOVED)) {
+        throw MakeLineError(line_number, "unknown status " + std::to_string(kStatus));
+    }
+    record.status = static_cast<DocumentStatus>(kStatus);
+
+    std::string_view ratings = TakeField(line, line_number);
+    while (!ratings.empty()) {
+        const size_t kSpace = std::min(ratings.find(' '), ratings.size());
+        if (kSpace > 0U) {
+            record.ratings.push_back(ParseNumber(ratings.substr(0U, kSpace), line_number));
+        }
+        ratings.remove_prefix(std::min(kSpace + 1U, ratings.size()));
+    }
+
+    record.text = line;
+    return record;
+}
+
+TokenizedRecord TokenizeCorpusLine(const SearchServer &search_server, std::string_view line, size_t line_number) {
+    CorpusRecord record = ParseCorpusLine(line, line_number);
+    return TokenizedRecord{record.id, record.status, std::move(record.ratings),
+                           search_server.TokenizeDocument(record.text)};
+}
+
+double IngestionStats::GetDocumentsPerSecond() const {
+    return elapsed.count() > 0.0 ? static_cast<double>(documents) / elapsed.count() : 0.0;
+}
+
+IngestionStats IngestCorpus(SearchServer &search_server, std::istream &input, const IngestionOptions &options) {
+    BoundedQueue<LineBatch> lines(options.queue_capacity);
+    BoundedQueue<TokenizedBatch> documents(options.queue_capacity);
+    const auto kCloseQueues = [&lines, &documents]() {
+        lines.Close();
+        documents.Close();
+    };
+
+    const auto kStartTime = Clock::now();
+
+    // a failing stage closes both queues, so the stages around it stop instead of blocking forever
+    auto reader = std::async(std::launch::async, [&]() {
+        try {
+            const size_t kBytes = ReadLines(input, options, lines);
+            lines.Close();
+            return kBytes;
+        } catch (...) {
+            kCloseQueues();
+            throw;
+        }
+    });
+    auto tokenizer = std::async(std::launch::async, [&]() {
+        try {
+            TokenizeLines(search_server, lines, documents);
+            documents.Close();
+        } catch (...) {
+            kCloseQueues();
+            throw;
+        }
+    });
+
+    IngestionStats stats;
+    auto last_report_time = kStartTime;
+    size_t last_report_documents = 0U;
+    try {
+        while (auto batch = documents.Pop()) {
+            for (const TokenizedRecord &record: batch->records) {
+                search_server.AddTokenizedDocument(record.id, record.words, record.status, record.ratings);
+            }
+            stats.documents += batch->records.size();
+
+            const auto kNow = Clock::now();
+            if (options.progress_output != nullptr && kNow - last_report_time >= options.report_interval) {
+                *options.progress_output << "Indexed " << stats.documents << " documents, "
+                                         << static_cast<size_t>(ComputeRate(stats.documents - last_report_documents,
+                                                                            kNow - last_report_time))
+                                         << " docs/sec" << std::endl;
+                last_report_time = kNow;
+                last_report_documents = stats.documents;
+            }
+        }
+    } catch (...) {
+        kCloseQueues();
+        throw;
+    }
+
+    stats.bytes = reader.get();
+    tokenizer.get();
+    stats.elapsed = Clock::now() - kStartTime;
+
+    if (options.progress_output != nullptr) {
+        *options.progress_output << "Indexed " << stats.documents << " documents in " << stats.elapsed.count()
+                                 << " s, " << static_cast<size_t>(stats.GetDocumentsPerSecond()) << " docs/sec"
+                                 << std::endl;
+    }
+    return stats;
+}
+
+IngestionStats IngestCorpus(SearchServer &search_server, const std::string &path, const IngestionOptions &options) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("cannot open corpus " + path);
+    }
+    return IngestCorpus(search_server, input, options);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One corpus line: id, status as its number, space separated ratings and the document text, joined by tabs
+struct CorpusRecord {
+    int id;
+    DocumentStatus status;
+    std::vector<int> ratings;
+    // points into the parsed line
+    std::string_view text;
+};
+
+// line_number only goes into error messages
+CorpusRecord ParseCorpusLine(std::string_view line, size_t line_number);
+
+// A parsed corpus line ready for AddTokenizedDocument, the words point into the line
+struct TokenizedRecord {
+    int id;
+    DocumentStatus status;
+    std::vector<int> ratings;
+    SearchServer::TokenizedDocument words;
+};
+
+TokenizedRecord TokenizeCorpusLine(const SearchServer &search_server, std::string_view line, size_t line_number);
+
+struct IngestionOptions {
+    // bytes requested from the stream by a single read
+    size_t read_buffer_size = 1U << 20U;
+    // lines handed between stages at once
+    size_t batch_size = 1024U;
+    // batches a stage may run ahead of the next one
+    size_t queue_capacity = 8U;
+    std::chrono::milliseconds report_interval{1000};
+    // progress lines go here, nullptr keeps the ingestion silent
+    std::ostream *progress_output = &std::cerr;
+};
+
+struct IngestionStats {
+    size_t documents = 0U;
+    size_t bytes = 0U;
+    std::chrono::duration<double> elapsed{};
+
+    double GetDocumentsPerSecond() const;
+};
+
+// Reads, tokenizes and indexes the corpus on three threads joined by bounded queues, so the stages overlap.
+// Blank lines are skipped. The first malformed line or rejected document stops the pipeline and its exception
+// is rethrown, documents indexed before it stay in the server.
+IngestionStats IngestCorpus(SearchServer &search_server, std::istream &input, const IngestionOptions &options = {});
+
+IngestionStats IngestCorpus(SearchServer &search_server, const std::string &path,
+                            const IngestionOptions &options = {});
@@ -0,0 +1,78 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void LogHistogram::Record(uint64_t value, uint64_t count) {
+    counts_[GetBucketIndex(value)] += count;
+    total_count_ += count;
+}
+
+void LogHistogram::Merge(const LogHistogram &other) {
+    for (size_t i = 0U; i < kBucketCount; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+}
+
+void LogHistogram::Reset() {
+    counts_.fill(0U);
+    total_count_ = 0U;
+}
+
+uint64_t LogHistogram::GetCount() const {
+    return total_count_;
+}
+
+uint64_t LogHistogram::GetPercentile(double percentile) const {
+    if (total_count_ == 0U) {
+        return 0U;
+    }
+    const double kRank = std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(total_count_));
+    const uint64_t kTargetCount = std::max<uint64_t>(static_cast<uint64_t>(kRank), 1U);
+
+    uint64_t seen = 0U;
+    for (size_t i = 0U; i < kBucketCount; ++i) {
+        seen += counts_[i];
+        if (seen >= kTargetCount) {
+            return GetBucketUpperBound(i);
+        }
+    }
+    return GetBucketUpperBound(kBucketCount - 1U);
+}
+
+uint64_t LogHistogram::GetP50() const {
+    return GetPercentile(50.0);
+}
+
+uint64_t LogHistogram::GetP90() const {
+    return GetPercentile(90.0);
+}
+
+uint64_t LogHistogram::GetP99() const {
+    return GetPercentile(99.0);
+}
+
+uint64_t LogHistogram::GetP999() const {
+    return GetPercentile(99.9);
+}
+
+size_t LogHistogram::GetBucketIndex(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+    // the highest set bit picks the power of two, the next four bits pick the linear bucket inside it
+    const auto kHighestBit = static_cast<unsigned>(63 - __builtin_clzll(value));
+    const uint64_t kMantissa = value >> (kHighestBit - 4U);
+    return (kHighestBit - 3U) * kSubBucketCount + static_cast<size_t>(kMantissa - kSubBucketCount);
+}
+
+uint64_t LogHistogram::GetBucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const auto kShift = static_cast<unsigned>(index / kSubBucketCount - 1U);
+    const uint64_t kLowerBound = (kSubBucketCount + index % kSubBucketCount) << kShift;
+    return kLowerBound + ((uint64_t{1} << kShift) - 1U);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Log-bucketed histogram in the spirit of HdrHistogram. Values below kSubBucketCount are exact, every higher power
+// of two is split into kSubBucketCount linear buckets, so a reported value is at most 1/16 above the recorded one.
+// Histograms of different threads or windows are combined with Merge.
+class LogHistogram {
+public:
+    static const size_t kSubBucketCount = 16U;
+    static const size_t kBucketCount = (64U - 4U + 1U) * kSubBucketCount;
+
+public:
+    void Record(uint64_t value, uint64_t count = 1U);
+
+    void Merge(const LogHistogram &other);
+
+    void Reset();
+
+    uint64_t GetCount() const;
+
+    // Highest value of the bucket holding the percentile-th recorded value, 0 for an empty histogram
+    uint64_t GetPercentile(double percentile) const;
+
+    uint64_t GetP50() const;
+
+    uint64_t GetP90() const;
+
+    uint64_t GetP99() const;
+
+    uint64_t GetP999() const;
+
+private:
+    static size_t GetBucketIndex(uint64_t value);
+
+    static uint64_t GetBucketUpperBound(size_t index);
+
+private:
+    std::array<uint64_t, kBucketCount> counts_{};
+    uint64_t total_count_ = 0U;
+};
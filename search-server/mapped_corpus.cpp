@@ -0,0 +1,142 @@
+#include "mapped_corpus.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <future>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+// a part holds at most this many bytes, so the parts in flight stay small whatever the corpus size
+constexpr size_t kMaxPartSize = 4U << 20U;
+// more parts than threads keep the threads busy while the indexing thread catches up with a slow part
+constexpr size_t kPartsPerThread = 4U;
+
+struct TokenizedPart {
+    std::vector<TokenizedRecord> records;
+    // the line that failed to parse, its number is only known once the preceding parts are counted
+    std::string_view failed_line;
+    std::exception_ptr error;
+};
+
+TokenizedPart TokenizePart(const SearchServer &search_server, std::string_view part) {
+    TokenizedPart tokenized;
+    while (!part.empty()) {
+        const size_t kNewline = std::min(part.find('\n'), part.size());
+        const std::string_view kLine = part.substr(0U, kNewline);
+        part.remove_prefix(std::min(kNewline + 1U, part.size()));
+        if (kLine.empty()) {
+            continue;
+        }
+        try {
+            tokenized.records.push_back(TokenizeCorpusLine(search_server, kLine, 0U));
+        } catch (...) {
+            tokenized.failed_line = kLine;
+            tokenized.error = std::current_exception();
+            break;
+        }
+    }
+    return tokenized;
+}
+
+}
+
+MappedFile::MappedFile(const std::string &path) {
+    const int kFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (kFd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open corpus " + path);
+    }
+
+    struct stat file_stat{};
+    if (fstat(kFd, &file_stat) != 0) {
+        const int kError = errno;
+        close(kFd);
+        throw std::system_error(kError, std::generic_category(), "cannot stat corpus " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+
+    // an empty file cannot be mapped, it stays an empty view
+    if (size_ > 0U) {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, kFd, 0);
+    }
+    const int kError = errno;
+    close(kFd);
+    if (data_ == MAP_FAILED) {
+        throw std::system_error(kError, std::generic_category(), "cannot map corpus " + path);
+    }
+    if (data_ != nullptr) {
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+    }
+}
+
+std::string_view MappedFile::GetContents() const {
+    return data_ == nullptr ? std::string_view() : std::string_view(static_cast<const char *>(data_), size_);
+}
+
+std::vector<std::string_view> SplitAtLineBoundaries(std::string_view text, size_t part_count) {
+    std::vector<std::string_view> parts;
+    const size_t kPartSize = text.size() / std::max<size_t>(part_count, 1U) + 1U;
+    while (!text.empty()) {
+        // the part runs up to the first newline at or after its nominal end
+        const size_t kNewline = kPartSize <= text.size() ? text.find('\n', kPartSize - 1U) : std::string_view::npos;
+        const size_t kSize = kNewline == std::string_view::npos ? text.size() : kNewline + 1U;
+        parts.push_back(text.substr(0U, kSize));
+        text.remove_prefix(kSize);
+    }
+    return parts;
+}
+
+IngestionStats LoadMappedCorpus(SearchServer &search_server, const std::string &path, size_t thread_count) {
+    const auto kStartTime = std::chrono::steady_clock::now();
+    const MappedFile kFile(path);
+    const std::string_view kContents = kFile.GetContents();
+
+    const size_t kThreadCount = std::max<size_t>(thread_count, 1U);
+    const auto kParts = SplitAtLineBoundaries(
+            kContents, std::max(kThreadCount * kPartsPerThread, kContents.size() / kMaxPartSize + 1U));
+
+    IngestionStats stats;
+    stats.bytes = kContents.size();
+    std::deque<std::future<TokenizedPart>> in_flight;
+    size_t next_part = 0U;
+    while (next_part < kParts.size() || !in_flight.empty()) {
+        // a part is launched only when an earlier one is indexed, so at most one part per thread is in memory
+        for (; next_part < kParts.size() && in_flight.size() < kThreadCount; ++next_part) {
+            in_flight.push_back(std::async(std::launch::async, TokenizePart, std::cref(search_server),
+                                           kParts[next_part]));
+        }
+        const TokenizedPart kPart = in_flight.front().get();
+        in_flight.pop_front();
+
+        for (const TokenizedRecord &record: kPart.records) {
+            search_server.AddTokenizedDocument(record.id, record.words, record.status, record.ratings);
+        }
+        stats.documents += kPart.records.size();
+
+        if (kPart.error) {
+            // parsing the line again with its real number rethrows the error with a useful message
+            const auto kLineNumber = static_cast<size_t>(
+                    std::count(kContents.data(), kPart.failed_line.data(), '\n')) + 1U;
+            TokenizeCorpusLine(search_server, kPart.failed_line, kLineNumber);
+            std::rethrow_exception(kPart.error);
+        }
+    }
+
+    stats.elapsed = std::chrono::steady_clock::now() - kStartTime;
+    return stats;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "corpus_ingestion.h"
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Read-only private mapping of a whole file, advised for sequential access. Unmapped on destruction.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+public:
+    std::string_view GetContents() const;
+
+private:
+    void *data_ = nullptr;
+    size_t size_ = 0U;
+};
+
+// At most part_count consecutive parts covering text, each part but the last ends right after a newline
+std::vector<std::string_view> SplitAtLineBoundaries(std::string_view text, size_t part_count);
+
+// Loads a corpus in the format of IngestCorpus straight from the mapped file. The file is split into more parts
+// than threads, each part is parsed and tokenized on its own thread into views of the mapping and indexed in file
+// order as soon as it is ready. At most thread_count parts are in flight, so the tokenized records held at once stay
+// bounded by the part size rather than the corpus size. The file contents are copied only for words new to the index.
+IngestionStats LoadMappedCorpus(SearchServer &search_server, const std::string &path,
+                                size_t thread_count = std::max(std::thread::hardware_concurrency(), 1U));
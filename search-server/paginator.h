@@ -1,7 +1,10 @@
 #pragma once
 
 #include <algorithm>
-#include <vector>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
 
 
 template<class Iterator>
@@ -30,43 +33,106 @@ private:
     Iterator last_;
 };
 
+// Pages are computed on demand. Random-access ranges also get O(1) size() and operator[],
+// other ranges can only be walked page by page, each page costing page_size steps.
 template<typename Iterator>
 class Paginator {
 public:
-    Paginator(Iterator first, Iterator last, int page_size)
-            : first_(first), last_(last), page_size_(page_size), pages_(CalculatePagesCount()) {
+    using Page = IteratorRange<Iterator>;
+
+    class PageIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Page;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Page *;
+        using reference = const Page &;
+
+        PageIterator(Iterator first, Iterator last, size_t page_size)
+                : page_(first, Paginator::AdvanceBy(first, last, page_size)), last_(last), page_size_(page_size) {
+        }
 
-        auto it = first;
-        for (auto &page: pages_) {
-            page = {it, next(it, std::min(page_size, static_cast<int>(distance(it, last))))};
-            std::advance(it, page_size);
+        reference operator*() const {
+            return page_;
         }
-    };
 
-    auto begin() const {
-        return pages_.begin();
-    };
+        pointer operator->() const {
+            return &page_;
+        }
 
-    auto end() const {
-        return pages_.end();
+        PageIterator &operator++() {
+            const Iterator kFirst = page_.end();
+            page_ = Page(kFirst, Paginator::AdvanceBy(kFirst, last_, page_size_));
+            return *this;
+        }
+
+        PageIterator operator++(int) {
+            PageIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const PageIterator &other) const {
+            return page_.begin() == other.page_.begin();
+        }
+
+        bool operator!=(const PageIterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        Page page_;
+        Iterator last_;
+        size_t page_size_;
     };
 
+    Paginator(Iterator first, Iterator last, size_t page_size)
+            : first_(first), last_(last), page_size_(page_size) {
+        if (page_size_ == 0U) {
+            throw std::invalid_argument("Page size must be positive");
+        }
+    }
+
+    PageIterator begin() const {
+        return PageIterator(first_, last_, page_size_);
+    }
+
+    PageIterator end() const {
+        return PageIterator(last_, last_, page_size_);
+    }
+
     size_t size() const {
-        return pages_.size();
+        static_assert(kIsRandomAccess, "Page count of a non random-access range is unknown until it is walked");
+        const auto kLength = static_cast<size_t>(last_ - first_);
+        return kLength / page_size_ + (kLength % page_size_ != 0U ? 1U : 0U);
     }
 
-private:
+    Page operator[](size_t index) const {
+        static_assert(kIsRandomAccess, "Pages of a non random-access range can only be walked in order");
+        const Iterator kFirst = first_ + static_cast<std::ptrdiff_t>(index * page_size_);
+        return Page(kFirst, AdvanceBy(kFirst, last_, page_size_));
+    }
 
-    size_t CalculatePagesCount() {
-        size_t len = std::distance(first_, last_);
-        return (len % page_size_) ? len / page_size_ + 1 : len / page_size_;
+private:
+    static constexpr bool kIsRandomAccess = std::is_base_of_v<
+            std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>;
+
+    // first advanced by count, but not past last
+    static Iterator AdvanceBy(Iterator first, Iterator last, size_t count) {
+        if constexpr (kIsRandomAccess) {
+            return first + static_cast<std::ptrdiff_t>(std::min(count, static_cast<size_t>(last - first)));
+        } else {
+            for (; count > 0U && first != last; --count) {
+                ++first;
+            }
+            return first;
+        }
     }
 
 private:
     Iterator first_;
     Iterator last_;
-    int page_size_;
-    std::vector<IteratorRange<Iterator>> pages_;
+    size_t page_size_;
 };
 
 template<typename Container>
@@ -0,0 +1,132 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+
+void ProfileStats::Record(uint64_t duration_ns) {
+    ++count;
+    total_ns += duration_ns;
+    min_ns = std::min(min_ns, duration_ns);
+    max_ns = std::max(max_ns, duration_ns);
+    histogram.Record(duration_ns);
+}
+
+void ProfileStats::Merge(const ProfileStats &other) {
+    count += other.count;
+    total_ns += other.total_ns;
+    min_ns = std::min(min_ns, other.min_ns);
+    max_ns = std::max(max_ns, other.max_ns);
+    histogram.Merge(other.histogram);
+}
+
+double ProfileStats::GetMeanNs() const {
+    return count > 0U ? static_cast<double>(total_ns) / static_cast<double>(count) : 0.0;
+}
+
+class Profiler::ThreadProfileHandle {
+public:
+    explicit ThreadProfileHandle(Profiler &profiler)
+            : profiler_(profiler), profile_(std::make_shared<ThreadProfile>()) {
+        std::lock_guard guard(profiler_.mutex_);
+        profiler_.thread_profiles_.push_back(profile_);
+    }
+
+    ~ThreadProfileHandle() {
+        std::lock_guard guard(profiler_.mutex_);
+        std::lock_guard profile_guard(profile_->mutex);
+        auto &retired_stats = profiler_.retired_stats_;
+        retired_stats.resize(std::max(retired_stats.size(), profile_->stats.size()));
+        for (size_t i = 0U; i < profile_->stats.size(); ++i) {
+            retired_stats[i].Merge(profile_->stats[i]);
+        }
+        auto &thread_profiles = profiler_.thread_profiles_;
+        thread_profiles.erase(std::find(thread_profiles.begin(), thread_profiles.end(), profile_));
+    }
+
+    ThreadProfile &GetProfile() {
+        return *profile_;
+    }
+
+private:
+    Profiler &profiler_;
+    const std::shared_ptr<ThreadProfile> profile_;
+};
+
+Profiler &Profiler::GetInstance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+size_t Profiler::RegisterLabel(std::string label) {
+    std::lock_guard guard(mutex_);
+    labels_.push_back(std::move(label));
+    return labels_.size() - 1U;
+}
+
+void Profiler::Record(size_t label_index, uint64_t duration_ns) {
+    ThreadProfile &profile = GetThreadProfile();
+    // contended only while a snapshot or a reset walks the threads
+    std::lock_guard guard(profile.mutex);
+    if (label_index >= profile.stats.size()) {
+        profile.stats.resize(label_index + 1U);
+    }
+    profile.stats[label_index].Record(duration_ns);
+}
+
+ProfileSnapshot Profiler::GetSnapshot() const {
+    std::lock_guard guard(mutex_);
+    std::vector<ProfileStats> stats(labels_.size());
+    const auto kMerge = [&stats](const std::vector<ProfileStats> &thread_stats) {
+        for (size_t i = 0U; i < thread_stats.size(); ++i) {
+            stats[i].Merge(thread_stats[i]);
+        }
+    };
+    kMerge(retired_stats_);
+    for (const auto &profile: thread_profiles_) {
+        std::lock_guard profile_guard(profile->mutex);
+        kMerge(profile->stats);
+    }
+
+    ProfileSnapshot snapshot;
+    for (size_t i = 0U; i < labels_.size(); ++i) {
+        if (stats[i].count > 0U) {
+            snapshot[labels_[i]].Merge(stats[i]);
+        }
+    }
+    return snapshot;
+}
+
+void Profiler::Reset() {
+    std::lock_guard guard(mutex_);
+    retired_stats_.clear();
+    for (const auto &profile: thread_profiles_) {
+        std::lock_guard profile_guard(profile->mutex);
+        profile->stats.clear();
+    }
+}
+
+void Profiler::PrintSnapshot(const ProfileSnapshot &snapshot, std::ostream &output) {
+    output << std::left << std::setw(40) << "scope" << std::right << std::setw(12) << "count" << std::setw(14)
+           << "mean ns" << std::setw(14) << "p50 ns" << std::setw(14) << "p99 ns" << std::setw(14) << "min ns"
+           << std::setw(14) << "max ns" << std::setw(14) << "total ms" << '\n';
+    output << std::fixed << std::setprecision(1);
+    for (const auto &[label, stats]: snapshot) {
+        output << std::left << std::setw(40) << label << std::right << std::setw(12) << stats.count << std::setw(14)
+               << stats.GetMeanNs() << std::setw(14) << stats.histogram.GetP50() << std::setw(14)
+               << stats.histogram.GetP99() << std::setw(14) << stats.min_ns << std::setw(14) << stats.max_ns
+               << std::setw(14) << static_cast<double>(stats.total_ns) / 1e6 << '\n';
+    }
+    output << std::defaultfloat << std::flush;
+}
+
+Profiler::ThreadProfile &Profiler::GetThreadProfile() {
+    thread_local ThreadProfileHandle handle(*this);
+    return handle.GetProfile();
+}
+
+ProfileSite::ProfileSite(std::string label) : index_(Profiler::GetInstance().RegisterLabel(std::move(label))) {}
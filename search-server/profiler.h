@@ -0,0 +1,129 @@
+#pragma once
+
+#include "histogram.h"
+#include "log_duration.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Aggregate of the samples of one label, in nanoseconds
+struct ProfileStats {
+    uint64_t count = 0U;
+    uint64_t total_ns = 0U;
+    uint64_t min_ns = std::numeric_limits<uint64_t>::max();
+    uint64_t max_ns = 0U;
+    LogHistogram histogram;
+
+    void Record(uint64_t duration_ns);
+
+    void Merge(const ProfileStats &other);
+
+    double GetMeanNs() const;
+};
+
+using ProfileSnapshot = std::map<std::string, ProfileStats>;
+
+// Process-wide collector behind PROFILE_SCOPE. Every thread records into its own aggregates, so threads never
+// contend with each other, only with a snapshot or a reset. Off by default, a disabled scope does not read the clock.
+class Profiler {
+public:
+    static Profiler &GetInstance();
+
+public:
+    void SetEnabled(bool enabled);
+
+    // Inline, every scope checks it
+    bool IsEnabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Index of a new site, sites sharing a label are merged in snapshots
+    size_t RegisterLabel(std::string label);
+
+    void Record(size_t label_index, uint64_t duration_ns);
+
+    // Aggregates of all threads, including exited ones, since the last reset. Labels without samples are left out.
+    ProfileSnapshot GetSnapshot() const;
+
+    void Reset();
+
+    static void PrintSnapshot(const ProfileSnapshot &snapshot, std::ostream &output);
+
+private:
+    struct ThreadProfile {
+        std::mutex mutex;
+        // by label index
+        std::vector<ProfileStats> stats;
+    };
+
+    // Registers the thread's profile on first use and folds it into retired_stats_ when the thread exits
+    class ThreadProfileHandle;
+
+private:
+    Profiler() = default;
+
+    ThreadProfile &GetThreadProfile();
+
+private:
+    std::atomic<bool> enabled_{false};
+    mutable std::mutex mutex_;
+    std::vector<std::string> labels_;
+    std::vector<std::shared_ptr<ThreadProfile>> thread_profiles_;
+    std::vector<ProfileStats> retired_stats_;
+};
+
+class ProfileSite {
+public:
+    explicit ProfileSite(std::string label);
+
+    size_t GetIndex() const {
+        return index_;
+    }
+
+private:
+    const size_t index_;
+};
+
+// Measures its own lifetime like LogDuration, but records it instead of printing it
+class ScopedProfile {
+public:
+    explicit ScopedProfile(const ProfileSite &site)
+            : label_index_(site.GetIndex()), is_enabled_(Profiler::GetInstance().IsEnabled()) {
+        if (is_enabled_) {
+            start_time_ = LogDuration::Clock::now();
+        }
+    }
+
+    ScopedProfile(const ScopedProfile &) = delete;
+
+    ScopedProfile &operator=(const ScopedProfile &) = delete;
+
+    ~ScopedProfile() {
+        if (is_enabled_) {
+            const auto kDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    LogDuration::Clock::now() - start_time_);
+            Profiler::GetInstance().Record(label_index_, static_cast<uint64_t>(kDuration.count()));
+        }
+    }
+
+private:
+    const size_t label_index_;
+    const bool is_enabled_;
+    LogDuration::Clock::time_point start_time_;
+};
+
+// Defining SEARCH_SERVER_NO_PROFILING compiles the scopes out entirely
+#ifdef SEARCH_SERVER_NO_PROFILING
+#define PROFILE_SCOPE(label) static_cast<void>(0)
+#else
+#define PROFILE_SCOPE(label)                                                                                    \
+    static const ProfileSite PROFILE_CONCAT(profileSite, __LINE__)(label);                                      \
+    const ScopedProfile UNIQUE_VAR_NAME_PROFILE(PROFILE_CONCAT(profileSite, __LINE__))
+#endif
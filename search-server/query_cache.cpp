@@ -0,0 +1,68 @@
+#include "query_cache.h"
+
+
+QueryCache::QueryCache(size_t max_entries, size_t max_bytes)
+        : max_entries_(max_entries), max_bytes_(max_bytes) {
+}
+
+const std::vector<Document> *QueryCache::Find(const std::string &key, uint64_t generation) {
+    Invalidate(generation);
+
+    const auto kIt = key_to_entry_.find(key);
+    if (kIt == key_to_entry_.end()) {
+        ++miss_count_;
+        return nullptr;
+    }
+    ++hit_count_;
+    entries_.splice(entries_.begin(), entries_, kIt->second);
+    return &kIt->second->documents;
+}
+
+void QueryCache::Insert(std::string key, std::vector<Document> documents, uint64_t generation) {
+    Invalidate(generation);
+
+    // the key is stored twice, in the entry and in the lookup table
+    const size_t kBytes = sizeof(Entry) + 2U * key.capacity() + documents.capacity() * sizeof(Document);
+    if (max_entries_ == 0U || kBytes > max_bytes_ || key_to_entry_.count(key)) {
+        return;
+    }
+    while (!entries_.empty() && (entries_.size() >= max_entries_ || memory_usage_ + kBytes > max_bytes_)) {
+        EvictLeastRecentlyUsed();
+    }
+
+    entries_.push_front(Entry{key, std::move(documents), kBytes});
+    key_to_entry_.emplace(std::move(key), entries_.begin());
+    memory_usage_ += kBytes;
+}
+
+size_t QueryCache::GetHitCount() const {
+    return hit_count_;
+}
+
+size_t QueryCache::GetMissCount() const {
+    return miss_count_;
+}
+
+size_t QueryCache::GetEntryCount() const {
+    return entries_.size();
+}
+
+size_t QueryCache::GetMemoryUsage() const {
+    return memory_usage_;
+}
+
+void QueryCache::Invalidate(uint64_t generation) {
+    if (generation == generation_) {
+        return;
+    }
+    generation_ = generation;
+    entries_.clear();
+    key_to_entry_.clear();
+    memory_usage_ = 0U;
+}
+
+void QueryCache::EvictLeastRecentlyUsed() {
+    memory_usage_ -= entries_.back().bytes;
+    key_to_entry_.erase(entries_.back().key);
+    entries_.pop_back();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "document.h"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bounded LRU cache of search results. Entries belong to one index generation of the server,
+// a lookup under another generation drops them all.
+class QueryCache {
+public:
+    QueryCache(size_t max_entries, size_t max_bytes);
+
+public:
+    // nullptr on a miss, the pointer is valid until the next Insert
+    const std::vector<Document> *Find(const std::string &key, uint64_t generation);
+
+    void Insert(std::string key, std::vector<Document> documents, uint64_t generation);
+
+    size_t GetHitCount() const;
+
+    size_t GetMissCount() const;
+
+    size_t GetEntryCount() const;
+
+    // Estimated bytes held by keys and cached results
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+        size_t bytes;
+    };
+
+    void Invalidate(uint64_t generation);
+
+    void EvictLeastRecentlyUsed();
+
+private:
+    const size_t max_entries_;
+    const size_t max_bytes_;
+    // most recently used first
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> key_to_entry_;
+    uint64_t generation_ = 0U;
+    size_t memory_usage_ = 0U;
+    size_t hit_count_ = 0U;
+    size_t miss_count_ = 0U;
+};
@@ -1,27 +1,239 @@
 #include "remove_duplicates.h"
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+
+namespace {
+
+using WordFrequencies = SearchServer::WordFrequencies;
+
+bool HasSameWords(const WordFrequencies &left, const WordFrequencies &right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end(),
+                      [](const auto &left_pair, const auto &right_pair) {
+                          return left_pair.first == right_pair.first;
+                      });
+}
+
+uint64_t MixBits(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27U)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31U);
+}
+
+// i-th value is the minimum of the i-th hash function over all words of the document
+std::vector<uint64_t> ComputeMinHashSignature(const WordFrequencies &word_frequencies, size_t signature_size) {
+    std::vector<uint64_t> signature(signature_size, std::numeric_limits<uint64_t>::max());
+    for (const auto &[word, _]: word_frequencies) {
+        const uint64_t kWordHash = std::hash<std::string_view>{}(word);
+        for (size_t i = 0U; i < signature_size; ++i) {
+            signature[i] = std::min(signature[i], MixBits(kWordHash ^ MixBits(i)));
+        }
+    }
+    return signature;
+}
+
+uint64_t ComputeBandKey(const std::vector<uint64_t> &signature, size_t band, size_t rows_per_band) {
+    uint64_t key = MixBits(band);
+    for (size_t i = band * rows_per_band; i < (band + 1U) * rows_per_band; ++i) {
+        key = MixBits(key ^ signature[i]);
+    }
+    return key;
+}
+
+double ComputeJaccardSimilarity(const WordFrequencies &left, const WordFrequencies &right) {
+    if (left.empty() && right.empty()) {
+        return 1.0;
+    }
+    size_t common_words = 0U;
+    auto left_it = left.begin();
+    auto right_it = right.begin();
+    while (left_it != left.end() && right_it != right.end()) {
+        if (left_it->first < right_it->first) {
+            ++left_it;
+        } else if (right_it->first < left_it->first) {
+            ++right_it;
+        } else {
+            ++common_words;
+            ++left_it;
+            ++right_it;
+        }
+    }
+    return static_cast<double>(common_words) / static_cast<double>(left.size() + right.size() - common_words);
+}
+
+// Banding of the signature, fewer longer bands mean fewer false candidates
+struct Banding {
+    size_t bands;
+    size_t rows_per_band;
+};
+
+// The longest bands that still make a pair of the given similarity a candidate with probability at least min_recall,
+// a pair becomes one when any band of its signatures matches, which happens with 1 - (1 - s^rows)^bands
+Banding ChooseBanding(double similarity, size_t signature_size, double min_recall) {
+    Banding banding{signature_size, 1U};
+    for (size_t rows = 2U; rows <= signature_size; ++rows) {
+        const size_t kBands = signature_size / rows;
+        const double kRecall = 1.0 - std::pow(1.0 - std::pow(similarity, static_cast<double>(rows)),
+                                              static_cast<double>(kBands));
+        if (kRecall >= min_recall) {
+            banding = {kBands, rows};
+        }
+    }
+    return banding;
+}
+
+void Report(const std::vector<int> &bin) {
+    for (const auto kId: bin) {
+        std::cout << "Found duplicate document id " << kId << '\n';
+    }
+    std::cout.flush();
+}
+
+}
 
 void RemoveDuplicates(SearchServer &search_server) {
-    std::set<std::set<std::string>> hash_table;
+    Report(RemoveDuplicates(std::execution::seq, search_server));
+}
+
+std::vector<int> RemoveDuplicates(const std::execution::sequenced_policy &, SearchServer &search_server) {
+    // fingerprint -> ids of kept documents, more than one only on a fingerprint collision
+    std::unordered_map<uint64_t, std::vector<int>> fingerprint_to_documents;
+    fingerprint_to_documents.reserve(search_server.GetDocumentCount());
 
     std::vector<int> bin;
     bin.reserve(search_server.GetDocumentCount());
 
+    // ids are visited in ascending order, so the lowest id of a group is kept
     for (const int kId: search_server) {
-        auto words_counter = search_server.GetWordFrequencies(kId);
-        std::set<std::string> words;
-        std::transform(words_counter.begin(), words_counter.end(),
-                       std::inserter(words, words.end()),
-                       [](const auto &pair) { return pair.first; });
-        if (hash_table.count(words)) {
+        const auto &kWords = search_server.GetWordFrequencies(kId);
+        auto &kept_documents = fingerprint_to_documents[SearchServer::ComputeWordSetFingerprint(kWords)];
+        const bool kIsDuplicate = std::any_of(kept_documents.begin(), kept_documents.end(),
+                                              [&search_server, &kWords](int kept_id) {
+                                                  return HasSameWords(search_server.GetWordFrequencies(kept_id),
+                                                                      kWords);
+                                              });
+        if (kIsDuplicate) {
             bin.push_back(kId);
             continue;
         }
-        hash_table.insert(words);
+        kept_documents.push_back(kId);
     }
 
-    for (const auto kId: bin) {
-        search_server.RemoveDocument(kId);
-        std::cout << "Found duplicate document id " << kId << std::endl;
+    search_server.RemoveDocuments(bin);
+    return bin;
+}
+
+std::vector<int> RemoveDuplicates(const std::execution::parallel_policy &, SearchServer &search_server) {
+    const std::vector<int> kIds(search_server.begin(), search_server.end());
+
+    // (fingerprint, id) pairs sorted by fingerprint and then by id
+    std::vector<std::pair<uint64_t, int>> fingerprints(kIds.size());
+    std::transform(std::execution::par, kIds.begin(), kIds.end(), fingerprints.begin(),
+                   [&search_server](int id) {
+                       return std::make_pair(
+                               SearchServer::ComputeWordSetFingerprint(search_server.GetWordFrequencies(id)), id);
+                   });
+    std::sort(std::execution::par, fingerprints.begin(), fingerprints.end());
+
+    // [first, last) runs of equal fingerprints
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t first = 0U; first < fingerprints.size();) {
+        size_t last = first + 1U;
+        while (last < fingerprints.size() && fingerprints[last].first == fingerprints[first].first) {
+            ++last;
+        }
+        if (last - first > 1U) {
+            runs.emplace_back(first, last);
+        }
+        first = last;
+    }
+
+    // within a run ids ascend, so a document is a duplicate only of an earlier kept one, as in the sequential pass
+    std::vector<char> is_duplicate(fingerprints.size(), 0);
+    std::for_each(std::execution::par, runs.begin(), runs.end(),
+                  [&search_server, &fingerprints, &is_duplicate](const std::pair<size_t, size_t> &run) {
+                      std::vector<int> kept_documents;
+                      for (size_t i = run.first; i < run.second; ++i) {
+                          const auto &kWords = search_server.GetWordFrequencies(fingerprints[i].second);
+                          const bool kIsDuplicate = std::any_of(
+                                  kept_documents.begin(), kept_documents.end(),
+                                  [&search_server, &kWords](int kept_id) {
+                                      return HasSameWords(search_server.GetWordFrequencies(kept_id), kWords);
+                                  });
+                          if (kIsDuplicate) {
+                              is_duplicate[i] = 1;
+                          } else {
+                              kept_documents.push_back(fingerprints[i].second);
+                          }
+                      }
+                  });
+
+    std::vector<int> bin;
+    for (size_t i = 0U; i < fingerprints.size(); ++i) {
+        if (is_duplicate[i]) {
+            bin.push_back(fingerprints[i].second);
+        }
+    }
+    std::sort(bin.begin(), bin.end());
+
+    search_server.RemoveDocuments(std::execution::par, bin);
+    return bin;
+}
+
+std::vector<int> RemoveNearDuplicates(SearchServer &search_server, const NearDuplicateOptions &options) {
+    if (!(options.jaccard_threshold > 0.0 && options.jaccard_threshold <= 1.0)) {
+        throw std::invalid_argument("Jaccard threshold must be in (0, 1]");
     }
+    if (options.signature_size == 0U) {
+        throw std::invalid_argument("Signature size must be positive");
+    }
+    const Banding kBanding = ChooseBanding(options.jaccard_threshold, options.signature_size, 0.99);
+    const size_t kSignatureSize = kBanding.bands * kBanding.rows_per_band;
+
+    // band key -> ids of kept documents that share this band of the signature
+    std::unordered_map<uint64_t, std::vector<int>> band_to_documents;
+    band_to_documents.reserve(search_server.GetDocumentCount() * kBanding.bands);
+
+    std::vector<int> bin;
+    std::vector<int> candidates;
+    std::vector<uint64_t> band_keys(kBanding.bands);
+
+    for (const int kId: search_server) {
+        const auto &kWords = search_server.GetWordFrequencies(kId);
+        const auto kSignature = ComputeMinHashSignature(kWords, kSignatureSize);
+
+        candidates.clear();
+        for (size_t band = 0U; band < kBanding.bands; ++band) {
+            band_keys[band] = ComputeBandKey(kSignature, band, kBanding.rows_per_band);
+            const auto kBucketIt = band_to_documents.find(band_keys[band]);
+            if (kBucketIt != band_to_documents.end()) {
+                candidates.insert(candidates.end(), kBucketIt->second.begin(), kBucketIt->second.end());
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        const bool kIsDuplicate = std::any_of(candidates.begin(), candidates.end(),
+                                              [&search_server, &kWords, &options](int kept_id) {
+                                                  return ComputeJaccardSimilarity(
+                                                          search_server.GetWordFrequencies(kept_id), kWords) >=
+                                                         options.jaccard_threshold;
+                                              });
+        if (kIsDuplicate) {
+            bin.push_back(kId);
+            continue;
+        }
+        for (const uint64_t kBandKey: band_keys) {
+            band_to_documents[kBandKey].push_back(kId);
+        }
+    }
+
+    search_server.RemoveDocuments(bin);
+    return bin;
 }
@@ -2,4 +2,28 @@
 
 #include "search_server.h"
 
+#include <execution>
+#include <vector>
+
+// Removes documents with the same word set as a document of lower id and prints their ids
 void RemoveDuplicates(SearchServer &search_server);
+
+// Same as above, but returns the removed ids in ascending order instead of printing them
+std::vector<int> RemoveDuplicates(const std::execution::sequenced_policy &, SearchServer &search_server);
+
+// Fingerprints documents on all cores, the lowest id of every group is kept as in the sequential version.
+// The duplicates are removed with RemoveDocuments(std::execution::par, ...), which frees postings concurrently
+// only when the server's memory resource allows it.
+std::vector<int> RemoveDuplicates(const std::execution::parallel_policy &, SearchServer &search_server);
+
+// Longer signatures estimate similarity more precisely and cost more per document
+struct NearDuplicateOptions {
+    double jaccard_threshold = 0.8;
+    size_t signature_size = 100U;
+};
+
+// Removes documents whose word set has Jaccard similarity of at least the threshold with a document of lower id,
+// returns the removed ids in ascending order. Candidates come from MinHash signatures bucketed per band, the bands
+// are sized so that a pair at the threshold becomes a candidate with 99% probability, and every candidate pair is
+// verified exactly. Throws std::invalid_argument unless 0 < jaccard_threshold <= 1 and signature_size > 0.
+std::vector<int> RemoveNearDuplicates(SearchServer &search_server, const NearDuplicateOptions &options = {});
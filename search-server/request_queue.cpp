@@ -1,38 +1,151 @@
 #include "request_queue.h"
 
+#include <stdexcept>
+
 std::vector<Document> RequestQueue::AddFindRequest(const std::string &raw_query, DocumentStatus status) {
-    auto result = search_server_.FindTopDocuments(raw_query, status);
-    CollectMetrics(result);
+    const auto kStartTime = Clock::now();
+    auto result = FindTopDocuments(raw_query, status);
+    CollectMetrics(result, Clock::now() - kStartTime);
     return result;
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string &raw_query) {
-    auto result = search_server_.FindTopDocuments(raw_query);
-    CollectMetrics(result);
-    return result;
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return empty_results_metric_;
+    if (now_ == nullptr) {
+        return empty_results_metric_;
+    }
+    return empty_results_metric_ - CountExpiredEmptyResults(GetCurrentTick());
+}
+
+LogHistogram RequestQueue::GetLatencyHistogram() const {
+    return MergeHistogramWindows([](const HistogramWindow &window) -> const LogHistogram & {
+        return window.latencies;
+    });
+}
+
+LogHistogram RequestQueue::GetResultCountHistogram() const {
+    return MergeHistogramWindows([](const HistogramWindow &window) -> const LogHistogram & {
+        return window.result_counts;
+    });
+}
+
+void RequestQueue::EnableResultCache(size_t max_entries, size_t max_bytes) {
+    result_cache_.emplace(max_entries, max_bytes);
+}
+
+const QueryCache *RequestQueue::GetResultCache() const {
+    return result_cache_ ? &*result_cache_ : nullptr;
+}
+
+std::vector<Document> RequestQueue::FindTopDocuments(const std::string &raw_query, DocumentStatus status) {
+    if (!result_cache_) {
+        return search_server_.FindTopDocuments(raw_query, status);
+    }
+
+    const uint64_t kGeneration = search_server_.GetIndexGeneration();
+    std::string key = std::to_string(static_cast<int>(status)) + ':' + search_server_.GetNormalizedQuery(raw_query);
+    if (const auto *kCached = result_cache_->Find(key, kGeneration)) {
+        return *kCached;
+    }
+
+    auto result = search_server_.FindTopDocuments(raw_query, status);
+    result_cache_->Insert(std::move(key), result, kGeneration);
+    return result;
 }
 
 RequestQueue::RequestQueue(const SearchServer &search_server, int time_window, int default_metric_value)
-        : search_server_(search_server), time_window_(time_window), empty_results_metric_(default_metric_value) {
+        : search_server_(search_server), timeline_(static_cast<size_t>(std::max(time_window, 1)), 0),
+          empty_results_metric_(default_metric_value), histogram_windows_(kHistogramWindowCount),
+          ticks_per_histogram_window_(
+                  (static_cast<int64_t>(timeline_.size()) + kHistogramWindowCount - 1) / kHistogramWindowCount) {
+
+}
+
+RequestQueue::RequestQueue(const SearchServer &search_server, Clock::duration window, Clock::duration bucket,
+                           Clock::time_point (*now)())
+        : search_server_(search_server),
+          timeline_(GetBucketCount(window, bucket)),
+          bucket_duration_(bucket), now_(now), start_time_(now()), histogram_windows_(kHistogramWindowCount),
+          ticks_per_histogram_window_(
+                  (static_cast<int64_t>(timeline_.size()) + kHistogramWindowCount - 1) / kHistogramWindowCount) {
 
 }
 
+size_t RequestQueue::GetBucketCount(Clock::duration window, Clock::duration bucket) {
+    if (window <= Clock::duration::zero()) {
+        throw std::invalid_argument("window must be positive");
+    }
+    if (bucket <= Clock::duration::zero()) {
+        throw std::invalid_argument("bucket must be positive");
+    }
+    return static_cast<size_t>(window / bucket + (window % bucket > Clock::duration::zero() ? 1 : 0));
+}
+
 void RequestQueue::CollectMetrics(const std::vector<Document> &result) {
+    // dequeue
+    const int64_t kTick = GetCurrentTick();
+    AdvanceTo(kTick);
+
     // enqueue
     if (result.empty()) {
+        ++timeline_[static_cast<size_t>(kTick) % timeline_.size()];
         ++empty_results_metric_;
     }
-    timeline_.push_back(static_cast<int>(result.size()));
+    ++request_count_;
 
-    // dequeue
-    while (static_cast<int>(timeline_.size()) > time_window_) {
-        if (timeline_.front() == 0) {
-            --empty_results_metric_;
-        }
-        timeline_.pop_front();
+    GetHistogramWindow(kTick).result_counts.Record(result.size());
+}
+
+void RequestQueue::CollectMetrics(const std::vector<Document> &result, Clock::duration latency) {
+    CollectMetrics(result);
+    const auto kNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    GetHistogramWindow(last_tick_).latencies.Record(static_cast<uint64_t>(kNanoseconds));
+}
+
+int64_t RequestQueue::GetCurrentTick() const {
+    if (now_ == nullptr) {
+        return request_count_;
+    }
+    return static_cast<int64_t>((now_() - start_time_) / bucket_duration_);
+}
+
+int64_t RequestQueue::GetReadTick() const {
+    return now_ == nullptr ? last_tick_ : GetCurrentTick();
+}
+
+RequestQueue::HistogramWindow &RequestQueue::GetHistogramWindow(int64_t tick) {
+    const int64_t kIndex = tick / ticks_per_histogram_window_;
+    HistogramWindow &window = histogram_windows_[static_cast<size_t>(kIndex % kHistogramWindowCount)];
+    if (window.index != kIndex) {
+        window.index = kIndex;
+        window.latencies.Reset();
+        window.result_counts.Reset();
+    }
+    return window;
+}
+
+int RequestQueue::CountExpiredEmptyResults(int64_t tick) const {
+    const auto kSize = static_cast<int64_t>(timeline_.size());
+    const int64_t kExpiredTicks = std::min(tick - last_tick_, kSize);
+
+    int expired = 0;
+    for (int64_t i = 1; i <= kExpiredTicks; ++i) {
+        expired += timeline_[static_cast<size_t>(last_tick_ + i) % timeline_.size()];
+    }
+    return expired;
+}
+
+void RequestQueue::AdvanceTo(int64_t tick) {
+    const auto kSize = static_cast<int64_t>(timeline_.size());
+    const int64_t kExpiredTicks = std::min(tick - last_tick_, kSize);
+
+    for (int64_t i = 1; i <= kExpiredTicks; ++i) {
+        int &slot = timeline_[static_cast<size_t>(last_tick_ + i) % timeline_.size()];
+        empty_results_metric_ -= slot;
+        slot = 0;
     }
+    last_tick_ = std::max(last_tick_, tick);
 }
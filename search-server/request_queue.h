@@ -1,13 +1,25 @@
 #pragma once
 
 #include "search_server.h"
+#include "histogram.h"
+#include "query_cache.h"
 
-#include <deque>
+#include <chrono>
+#include <cstdint>
+#include <optional>
 
 class RequestQueue {
 public:
+    using Clock = std::chrono::steady_clock;
+
+    // The window covers the last time_window requests, every request counts as one tick
     explicit RequestQueue(const SearchServer &search_server, int time_window = 1440, int default_metric_value = 0);
 
+    // The window covers the last window of real time, counted in buckets of bucket duration.
+    // Throws std::invalid_argument unless both durations are positive.
+    RequestQueue(const SearchServer &search_server, Clock::duration window, Clock::duration bucket,
+                 Clock::time_point (*now)() = &Clock::now);
+
 public:
     template<typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string &raw_query, DocumentPredicate document_predicate);
@@ -18,19 +30,85 @@ public:
 
     int GetNoResultRequests() const;
 
+    // Nanoseconds spent in FindTopDocuments over the window, rounded to 1/kHistogramWindowCount of it
+    LogHistogram GetLatencyHistogram() const;
+
+    // Result sizes over the same window as the latency histogram
+    LogHistogram GetResultCountHistogram() const;
+
+    // Caches results of status-filtered requests by normalized query, predicate requests always search
+    void EnableResultCache(size_t max_entries, size_t max_bytes);
+
+    // nullptr while the cache is disabled
+    const QueryCache *GetResultCache() const;
+
+    // Buckets needed to cover the window, throws std::invalid_argument unless both durations are positive
+    static size_t GetBucketCount(Clock::duration window, Clock::duration bucket);
+
 public:
     void CollectMetrics(const std::vector<Document> &result);
 
+    void CollectMetrics(const std::vector<Document> &result, Clock::duration latency);
+
+private:
+    static const int64_t kHistogramWindowCount = 16;
+
+    // Histograms of one of kHistogramWindowCount consecutive slices of the window
+    struct HistogramWindow {
+        int64_t index = -1;
+        LogHistogram latencies;
+        LogHistogram result_counts;
+    };
+
+    std::vector<Document> FindTopDocuments(const std::string &raw_query, DocumentStatus status);
+
+    int64_t GetCurrentTick() const;
+
+    // The last recorded tick for the request window, the current one for the wall-clock window
+    int64_t GetReadTick() const;
+
+    HistogramWindow &GetHistogramWindow(int64_t tick);
+
+    template<typename HistogramGetter>
+    LogHistogram MergeHistogramWindows(HistogramGetter get_histogram) const;
+
+    // Sum of the ticks that have left the window since the last recorded tick
+    int CountExpiredEmptyResults(int64_t tick) const;
+
+    void AdvanceTo(int64_t tick);
+
 private:
     const SearchServer &search_server_;
-    std::deque<int> timeline_;
-    const int time_window_;
+    // ring of empty result counts per tick, tick t lives in slot t % size
+    std::vector<int> timeline_;
+    int64_t last_tick_ = 0;
+    int64_t request_count_ = 0;
+    const Clock::duration bucket_duration_ = Clock::duration::zero();
+    Clock::time_point (*const now_)() = nullptr;
+    const Clock::time_point start_time_{};
     int empty_results_metric_ = 0;
+    std::vector<HistogramWindow> histogram_windows_;
+    int64_t ticks_per_histogram_window_ = 1;
+    std::optional<QueryCache> result_cache_;
 };
 
 template<typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string &raw_query, DocumentPredicate document_predicate) {
+    const auto kStartTime = Clock::now();
     auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
-    CollectMetrics(result);
+    CollectMetrics(result, Clock::now() - kStartTime);
     return result;
 }
+
+template<typename HistogramGetter>
+LogHistogram RequestQueue::MergeHistogramWindows(HistogramGetter get_histogram) const {
+    const int64_t kCurrentIndex = GetReadTick() / ticks_per_histogram_window_;
+
+    LogHistogram merged;
+    for (const HistogramWindow &window: histogram_windows_) {
+        if (window.index > kCurrentIndex - kHistogramWindowCount && window.index <= kCurrentIndex) {
+            merged.Merge(get_histogram(window));
+        }
+    }
+    return merged;
+}
@@ -1,5 +1,23 @@
 #include "search_server.h"
 
+#include <cstring>
+#include <sstream>
+
+
+namespace {
+
+// A red-black tree node of the standard library: colour and three links ahead of the value
+template<typename Value>
+constexpr size_t kTreeNodeSize = 4U * sizeof(void *) + sizeof(Value);
+
+// Characters of a string that did not fit into its inline buffer
+template<typename String>
+size_t GetHeapStringBytes(const String &text) {
+    return text.capacity() > String().capacity() ? text.capacity() + 1U : 0U;
+}
+
+}
+
 
 const std::set<std::string> &SearchServer::Query::GetPlusWords() const {
     return plus_words_;
@@ -17,23 +35,188 @@ std::set<std::string> &SearchServer::Query::GetMinusWords() {
     return minus_words_;
 }
 
+SearchServer::WordFrequencies::WordFrequencies(const ForwardEntry *first, const ForwardEntry *last)
+        : first_(first), last_(last) {
+}
+
+SearchServer::WordFrequencies::Iterator SearchServer::WordFrequencies::begin() const {
+    return Iterator(first_);
+}
+
+SearchServer::WordFrequencies::Iterator SearchServer::WordFrequencies::end() const {
+    return Iterator(last_);
+}
+
+size_t SearchServer::WordFrequencies::size() const {
+    return static_cast<size_t>(last_ - first_);
+}
+
+bool SearchServer::WordFrequencies::empty() const {
+    return first_ == last_;
+}
+
+SearchServer::WordFrequencies::Iterator SearchServer::WordFrequencies::find(std::string_view word) const {
+    const ForwardEntry *kEntry = std::lower_bound(first_, last_, word,
+                                                  [](const ForwardEntry &entry, std::string_view value) {
+                                                      return entry.term->first < value;
+                                                  });
+    if (kEntry != last_ && kEntry->term->first == word) {
+        return Iterator(kEntry);
+    }
+    return end();
+}
+
+size_t SearchServer::WordFrequencies::count(std::string_view word) const {
+    return find(word) == end() ? 0U : 1U;
+}
+
 void SearchServer::SetStopWords(const std::string &text) {
     for (const std::string &word: SplitIntoWords(text)) {
-        stop_words_.insert(word);
+        stop_words_.emplace(word);
     }
+    ++index_generation_;
+}
+
+int SearchServer::AddDocument(int document_id, const std::string &document, DocumentStatus status,
+                              const std::vector<int> &ratings) {
+    return AddTokenizedDocument(document_id, TokenizeDocument(document), status, ratings);
 }
 
-void SearchServer::AddDocument(int document_id, const std::string &document, DocumentStatus status,
-                               const std::vector<int> &ratings) {
+SearchServer::TokenizedDocument SearchServer::TokenizeDocument(std::string_view document) const {
+    std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
+    const double kInvertedWordCount = 1.0 / static_cast<double>(words.size());
+    std::sort(words.begin(), words.end());
+
+    // distinct words sorted, as they are laid out in the forward index
+    TokenizedDocument word_frequencies;
+    for (const std::string_view word: words) {
+        if (word_frequencies.empty() || word_frequencies.back().first != word) {
+            word_frequencies.emplace_back(word, 0.0);
+        }
+        word_frequencies.back().second += kInvertedWordCount;
+    }
+    return word_frequencies;
+}
+
+int SearchServer::AddTokenizedDocument(int document_id, const TokenizedDocument &word_frequencies,
+                                       DocumentStatus status, const std::vector<int> &ratings) {
+    PROFILE_SCOPE("SearchServer::AddDocument");
     CheckDocumentId(document_id);
-    const std::vector<std::string> kWords = SplitIntoWordsNoStop(document);
-    const double kInvertedWordCount = 1.0 / static_cast<double>(kWords.size());
-    for (const std::string &word: kWords) {
-        word_to_document_frequency_[word][document_id] += kInvertedWordCount;
-        document_to_word_frequency_[document_id][word] += kInvertedWordCount;
+    if (removed_documents_.count(document_id)) {
+        // the id is reused before compaction reached it, so its stale postings must go first
+        EraseDocumentPostings(document_id, std::numeric_limits<size_t>::max());
+        removed_documents_.erase(document_id);
+        ShrinkForwardIndex();
+    }
+
+    if (duplicate_policy_ != DuplicatePolicy::KEEP) {
+        const uint64_t kFingerprint = ComputeWordSetFingerprint(word_frequencies);
+        const auto kCanonicalId = FindDocumentWithSameWords(kFingerprint, word_frequencies);
+        if (kCanonicalId && duplicate_policy_ == DuplicatePolicy::REJECT) {
+            return *kCanonicalId;
+        }
+        if (kCanonicalId && duplicate_policy_ == DuplicatePolicy::LINK) {
+            duplicate_to_canonical_[document_id] = *kCanonicalId;
+            canonical_to_duplicates_[*kCanonicalId].push_back(document_id);
+            return *kCanonicalId;
+        }
+        if (kCanonicalId) {
+            RemoveDocument(*kCanonicalId);
+        }
+        fingerprint_to_documents_[kFingerprint].push_back(document_id);
+    }
+
+    ++index_generation_;
+    document_to_forward_run_[document_id] = ForwardRun{forward_index_.size(), word_frequencies.size()};
+    for (const auto &[word, frequency]: word_frequencies) {
+        auto term = inverted_index_->postings.lower_bound(word);
+        if (term == inverted_index_->postings.end() || term->first != word) {
+            const std::string_view kTerm = *terms_.emplace(word).first;
+            term = inverted_index_->postings.emplace_hint(term, std::piecewise_construct, std::forward_as_tuple(kTerm),
+                                                          std::forward_as_tuple());
+        }
+        term->second.documents[document_id] = frequency;
+        forward_index_.push_back(ForwardEntry{term, frequency});
     }
     documents_.insert(document_id);
     storage_.insert({document_id, DocumentData{ComputeAverageRating(ratings), status}});
+    return document_id;
+}
+
+void SearchServer::SetDuplicatePolicy(DuplicatePolicy policy) {
+    const bool kWasTracked = duplicate_policy_ != DuplicatePolicy::KEEP;
+    duplicate_policy_ = policy;
+    if (policy == DuplicatePolicy::KEEP) {
+        fingerprint_to_documents_.clear();
+    } else if (!kWasTracked) {
+        for (const int kDocumentId: documents_) {
+            RegisterFingerprint(kDocumentId);
+        }
+    }
+}
+
+int SearchServer::GetCanonicalDocumentId(int document_id) const {
+    const auto kIt = duplicate_to_canonical_.find(document_id);
+    return kIt == duplicate_to_canonical_.end() ? document_id : kIt->second;
+}
+
+std::optional<int> SearchServer::FindDocumentWithSameWords(uint64_t fingerprint,
+                                                           const TokenizedDocument &word_frequencies) const {
+    const auto kBucketIt = fingerprint_to_documents_.find(fingerprint);
+    if (kBucketIt == fingerprint_to_documents_.end()) {
+        return std::nullopt;
+    }
+    for (const int kDocumentId: kBucketIt->second) {
+        const auto kWords = GetForwardEntries(kDocumentId);
+        if (std::equal(kWords.begin(), kWords.end(), word_frequencies.begin(), word_frequencies.end(),
+                       [](const auto &left, const auto &right) { return left.first == right.first; })) {
+            return kDocumentId;
+        }
+    }
+    return std::nullopt;
+}
+
+bool SearchServer::UnlinkDuplicate(int document_id) {
+    const auto kLinkIt = duplicate_to_canonical_.find(document_id);
+    if (kLinkIt == duplicate_to_canonical_.end()) {
+        return false;
+    }
+    const auto kDuplicatesIt = canonical_to_duplicates_.find(kLinkIt->second);
+    auto &duplicates = kDuplicatesIt->second;
+    duplicates.erase(std::remove(duplicates.begin(), duplicates.end(), document_id), duplicates.end());
+    if (duplicates.empty()) {
+        canonical_to_duplicates_.erase(kDuplicatesIt);
+    }
+    duplicate_to_canonical_.erase(kLinkIt);
+    return true;
+}
+
+void SearchServer::RegisterFingerprint(int document_id) {
+    fingerprint_to_documents_[ComputeWordSetFingerprint(GetForwardEntries(document_id))].push_back(document_id);
+}
+
+void SearchServer::ForgetFingerprint(int document_id) {
+    const auto kDuplicatesIt = canonical_to_duplicates_.find(document_id);
+    if (kDuplicatesIt != canonical_to_duplicates_.end()) {
+        for (const int kDuplicateId: kDuplicatesIt->second) {
+            duplicate_to_canonical_.erase(kDuplicateId);
+        }
+        canonical_to_duplicates_.erase(kDuplicatesIt);
+    }
+
+    if (duplicate_policy_ == DuplicatePolicy::KEEP) {
+        return;
+    }
+    const auto kBucketIt = fingerprint_to_documents_.find(
+            ComputeWordSetFingerprint(GetForwardEntries(document_id)));
+    if (kBucketIt == fingerprint_to_documents_.end()) {
+        return;
+    }
+    auto &documents = kBucketIt->second;
+    documents.erase(std::remove(documents.begin(), documents.end(), document_id), documents.end());
+    if (documents.empty()) {
+        fingerprint_to_documents_.erase(kBucketIt);
+    }
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string &raw_query, DocumentStatus status) const {
@@ -46,48 +229,207 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string &raw_quer
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
-std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string &raw_query,
-                                                                                 int document_id) const {
-    const Query kQuery = ParseQuery(raw_query);
-    std::vector<std::string> matched_words;
+std::vector<Document> SearchServer::FindTopDocuments(const std::string &raw_query, DocumentStatus status,
+                                                     QueryStats &stats) const {
+    return FindTopDocuments(raw_query, [&status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    }, stats);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string &raw_query, QueryStats &stats) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL, stats);
+}
 
+SearchServer::QueryExplanation SearchServer::ExplainQuery(const std::string &raw_query) const {
+    using Clock = LogDuration::Clock;
+
+    QueryExplanation explanation;
+    auto phase_start = Clock::now();
+    const auto kEndPhase = [&phase_start](std::chrono::nanoseconds &phase_time) {
+        const auto kNow = Clock::now();
+        phase_time = std::chrono::duration_cast<std::chrono::nanoseconds>(kNow - phase_start);
+        phase_start = kNow;
+    };
+
+    // the phases of FindTopDocuments(raw_query), run one at a time
+    const Query kQuery = ParseQuery(raw_query);
+    kEndPhase(explanation.parse_time);
+
+    std::array<std::byte, kQueryScratchBufferSize> scratch_buffer;
+    std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource_);
+    const QueryPlan kPlan = PlanQuery(kQuery, &scratch);
+    kEndPhase(explanation.plan_time);
+
+    std::pmr::map<int, double> document_to_relevance(&scratch);
+    ScoreDocuments(kPlan, [](int, DocumentStatus status, int) {
+        return status == DocumentStatus::ACTUAL;
+    }, explanation.stats, document_to_relevance);
+    explanation.documents = MakeDocuments(document_to_relevance);
+    kEndPhase(explanation.score_time);
+
+    explanation.stats.candidates_sorted = explanation.documents.size();
+    SelectTopDocuments(explanation.documents);
+    kEndPhase(explanation.sort_time);
+
+    // terms are described after the timed phases, so that their lookups are not counted in them
+    explanation.strategy = kPlan.strategy;
     for (const std::string &word: kQuery.GetPlusWords()) {
-        if (word_to_document_frequency_.count(word) == 1U) {
-            if (word_to_document_frequency_.at(word).count(document_id) == 1U) {
-                matched_words.push_back(word);
-            }
-        }
+        explanation.plus_terms.push_back(ExplainTerm(word));
     }
-
     for (const std::string &word: kQuery.GetMinusWords()) {
-        if (word_to_document_frequency_.count(word) == 1U) {
-            if (word_to_document_frequency_.at(word).count(document_id) == 1U) {
-                matched_words.clear();
-                break;
-            }
-        }
+        explanation.minus_terms.push_back(ExplainTerm(word));
+    }
+    return explanation;
+}
+
+SearchServer::ResultPage SearchServer::FindTopDocumentsPage(const std::string &raw_query, DocumentStatus status,
+                                                            size_t page_size,
+                                                            const std::string &continuation_token) const {
+    return FindTopDocumentsPage(raw_query, [&status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    }, page_size, continuation_token);
+}
+
+SearchServer::ResultPage SearchServer::FindTopDocumentsPage(const std::string &raw_query, size_t page_size,
+                                                            const std::string &continuation_token) const {
+    return FindTopDocumentsPage(raw_query, DocumentStatus::ACTUAL, page_size, continuation_token);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(const std::string &raw_query,
+                                                                                 int document_id) const {
+    const auto[kWords, kStatus] = MatchDocumentView(raw_query, document_id);
+    return {std::vector<std::string>(kWords.begin(), kWords.end()), kStatus};
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocumentView(const std::string &raw_query,
+                                                                                          int document_id) const {
+    std::vector<std::string_view> matched_words;
+    const DocumentStatus kStatus = MatchDocument(raw_query, document_id, matched_words);
+    return {matched_words, kStatus};
+}
+
+DocumentStatus SearchServer::MatchDocument(const std::string &raw_query, int document_id,
+                                           std::vector<std::string_view> &matched_words) const {
+    NoQueryStats stats;
+    return MatchDocumentWithStats(raw_query, document_id, matched_words, stats);
+}
+
+DocumentStatus SearchServer::MatchDocument(const std::string &raw_query, int document_id,
+                                           std::vector<std::string_view> &matched_words, QueryStats &stats) const {
+    return MatchDocumentWithStats(raw_query, document_id, matched_words, stats);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(
+        const std::execution::sequenced_policy &, const std::string &raw_query, int document_id) const {
+    return MatchDocument(raw_query, document_id);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> SearchServer::MatchDocument(
+        const std::execution::parallel_policy &, const std::string &raw_query, int document_id) const {
+    const QueryWords kQuery = ParseQueryWords(raw_query);
+    const DocumentStatus kStatus = storage_.at(document_id).status;
+    const auto &kWordFrequencies = GetWordFrequencies(document_id);
+
+    const auto kContainsWord = [&kWordFrequencies](const std::string &word) {
+        return kWordFrequencies.count(word) > 0U;
+    };
+
+    if (std::any_of(std::execution::par, kQuery.minus_words.begin(), kQuery.minus_words.end(), kContainsWord)) {
+        return {std::vector<std::string>{}, kStatus};
     }
 
-    return {matched_words, storage_.at(document_id).status};
+    std::vector<std::string> matched_words(kQuery.plus_words.size());
+    const auto kLast = std::copy_if(std::execution::par, kQuery.plus_words.begin(), kQuery.plus_words.end(),
+                                    matched_words.begin(), kContainsWord);
+    std::sort(matched_words.begin(), kLast);
+    matched_words.erase(std::unique(matched_words.begin(), kLast), matched_words.end());
 
+    return {matched_words, kStatus};
 }
 
 size_t SearchServer::GetDocumentCount() const {
     return storage_.size();
 }
 
-bool SearchServer::IsStopWord(const std::string &word) const {
+SearchServer::MemoryStats SearchServer::GetMemoryStats() const {
+    MemoryStats stats;
+    const Postings &kPostings = inverted_index_->postings;
+    stats.term_count = kPostings.size();
+    stats.posting_count = forward_index_.size() - forward_index_garbage_;
+    stats.document_count = documents_.size();
+    stats.average_posting_length = stats.term_count == 0U
+                                   ? 0.0
+                                   : static_cast<double>(stats.posting_count) / static_cast<double>(stats.term_count);
+
+    stats.term_dictionary_bytes = stats.term_count * (kTreeNodeSize<Postings::value_type> +
+                                                      kTreeNodeSize<std::pmr::string>);
+    for (const auto &term: terms_) {
+        stats.term_dictionary_bytes += GetHeapStringBytes(term);
+    }
+    stats.postings_bytes = stats.posting_count * kTreeNodeSize<std::pmr::map<int, double>::value_type>;
+
+    stats.forward_index_bytes = forward_index_.capacity() * sizeof(ForwardEntry) +
+                                document_to_forward_run_.size() * kTreeNodeSize<std::pair<const int, ForwardRun>>;
+
+    stats.document_metadata_bytes = storage_.size() * kTreeNodeSize<std::pair<const int, DocumentData>> +
+                                    (documents_.size() + removed_documents_.size()) * kTreeNodeSize<int>;
+    // fingerprint buckets hold one id each but on collisions, every link is a map node and an id in a list
+    stats.document_metadata_bytes += fingerprint_to_documents_.bucket_count() * sizeof(void *) +
+                                     fingerprint_to_documents_.size() *
+                                     (sizeof(void *) + sizeof(std::pair<const uint64_t, std::pmr::vector<int>>) +
+                                      sizeof(int));
+    stats.document_metadata_bytes += duplicate_to_canonical_.size() *
+                                     (kTreeNodeSize<std::pair<const int, int>> + sizeof(int)) +
+                                     canonical_to_duplicates_.size() *
+                                     kTreeNodeSize<std::pair<const int, std::pmr::vector<int>>>;
+
+    stats.stop_words_bytes = stop_words_.size() * kTreeNodeSize<std::pmr::string>;
+    for (const auto &word: stop_words_) {
+        stats.stop_words_bytes += GetHeapStringBytes(word);
+    }
+    return stats;
+}
+
+size_t SearchServer::MemoryStats::GetTotalBytes() const {
+    return term_dictionary_bytes + postings_bytes + forward_index_bytes + document_metadata_bytes +
+           stop_words_bytes;
+}
+
+uint64_t SearchServer::GetIndexGeneration() const {
+    return index_generation_;
+}
+
+std::string SearchServer::GetNormalizedQuery(const std::string &raw_query) const {
+    const Query kQuery = ParseQuery(raw_query);
+    std::string normalized;
+    for (const std::string &word: kQuery.GetPlusWords()) {
+        if (!normalized.empty()) {
+            normalized += ' ';
+        }
+        normalized += word;
+    }
+    for (const std::string &word: kQuery.GetMinusWords()) {
+        if (!normalized.empty()) {
+            normalized += ' ';
+        }
+        normalized += kMinusWordPrefix;
+        normalized += word;
+    }
+    return normalized;
+}
+
+bool SearchServer::IsStopWord(std::string_view word) const {
     return stop_words_.count(word) > 0U;
 }
 
-std::vector<std::string> SearchServer::SplitIntoWordsNoStop(const std::string &text) const {
-    std::vector<std::string> words;
-    for (const std::string &word: SplitIntoWords(text)) {
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
+    std::vector<std::string_view> words;
+    for (const std::string_view word: SplitIntoWordsView(text)) {
         if (!IsStopWord(word)) {
             words.push_back(word);
         }
         if (!IsValidWord(word)) {
-            throw std::invalid_argument("invalid word: " + word);
+            throw std::invalid_argument("invalid word: " + std::string(word));
         }
     }
     return words;
@@ -120,27 +462,84 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string text) const {
     return result;
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string &text) const {
-    Query query;
+SearchServer::QueryWords SearchServer::ParseQueryWords(const std::string &text) const {
+    QueryWords query;
     for (const std::string &word: SplitIntoWords(text)) {
-        const QueryWord kQueryWord = ParseQueryWord(word);
-        if (!kQueryWord.is_stop) {
-            if (kQueryWord.is_minus) {
-                query.GetMinusWords().insert(kQueryWord.data);
+        QueryWord query_word = ParseQueryWord(word);
+        if (!query_word.is_stop) {
+            if (query_word.is_minus) {
+                query.minus_words.push_back(std::move(query_word.data));
             } else {
-                query.GetPlusWords().insert(kQueryWord.data);
+                query.plus_words.push_back(std::move(query_word.data));
             }
         }
     }
     return query;
 }
 
-double SearchServer::ComputeWordInverseDocumentFrequency(const std::string &word) const {
-    return log(
-            static_cast<double>(GetDocumentCount()) / static_cast<double>(word_to_document_frequency_.at(word).size()));
+SearchServer::Query SearchServer::ParseQuery(const std::string &text) const {
+    QueryWords query_words = ParseQueryWords(text);
+    Query query;
+    query.GetPlusWords().insert(std::make_move_iterator(query_words.plus_words.begin()),
+                                std::make_move_iterator(query_words.plus_words.end()));
+    query.GetMinusWords().insert(std::make_move_iterator(query_words.minus_words.begin()),
+                                 std::make_move_iterator(query_words.minus_words.end()));
+    return query;
 }
 
-std::vector<Document> SearchServer::MakeDocuments(const std::map<int, double> &document_to_relevance) const {
+double SearchServer::ComputeInverseDocumentFrequency(size_t document_frequency) const {
+    return log(static_cast<double>(GetDocumentCount()) / static_cast<double>(document_frequency));
+}
+
+SearchServer::QueryPlan::QueryPlan(std::pmr::memory_resource *resource)
+        : plus_terms(resource), minus_terms(resource) {}
+
+SearchServer::QueryPlan SearchServer::PlanQuery(const Query &query, std::pmr::memory_resource *resource) const {
+    QueryPlan plan(resource);
+    const auto kResolve = [this](const std::set<std::string> &words, std::pmr::vector<PlannedTerm> &terms) {
+        for (const std::string &word: words) {
+            const auto kTermIt = inverted_index_->postings.find(std::string_view(word));
+            // a term left only with tombstoned documents matches nothing
+            if (kTermIt != inverted_index_->postings.end() && kTermIt->second.GetLiveCount() > 0U) {
+                terms.push_back({kTermIt, ComputeInverseDocumentFrequency(kTermIt->second.GetLiveCount())});
+            }
+        }
+    };
+
+    kResolve(query.GetPlusWords(), plan.plus_terms);
+    if (plan.plus_terms.empty()) {
+        // minus words could only exclude documents that are never scored, so they are not even looked up
+        return plan;
+    }
+    plan.strategy = QueryStrategy::TERM_AT_A_TIME;
+    kResolve(query.GetMinusWords(), plan.minus_terms);
+    return plan;
+}
+
+void SearchServer::SelectTopDocuments(std::vector<Document> &documents) const {
+    std::sort(documents.begin(), documents.end());
+    if (documents.size() > kMaxResultDocumentSize) {
+        documents.resize(kMaxResultDocumentSize);
+    }
+}
+
+SearchServer::QueryTermExplanation SearchServer::ExplainTerm(const std::string &word) const {
+    QueryTermExplanation explanation;
+    explanation.word = word;
+    const auto kTermIt = inverted_index_->postings.find(std::string_view(word));
+    if (kTermIt == inverted_index_->postings.end()) {
+        return explanation;
+    }
+    explanation.is_indexed = true;
+    explanation.posting_list_length = kTermIt->second.documents.size();
+    explanation.document_frequency = kTermIt->second.GetLiveCount();
+    if (explanation.document_frequency > 0U) {
+        explanation.inverse_document_frequency = ComputeInverseDocumentFrequency(explanation.document_frequency);
+    }
+    return explanation;
+}
+
+std::vector<Document> SearchServer::MakeDocuments(const std::pmr::map<int, double> &document_to_relevance) const {
     std::vector<Document> documents;
     documents.reserve(document_to_relevance.size());
 
@@ -151,7 +550,37 @@ std::vector<Document> SearchServer::MakeDocuments(const std::map<int, double> &d
     return documents;
 }
 
-bool SearchServer::IsValidWord(const std::string &word) {
+bool SearchServer::IsRankedBefore(const Document &left, const Document &right) {
+    if (left.relevance != right.relevance) {
+        return left.relevance > right.relevance;
+    }
+    if (left.rating != right.rating) {
+        return left.rating > right.rating;
+    }
+    return left.id < right.id;
+}
+
+std::string SearchServer::EncodeContinuationToken(const Document &document) {
+    uint64_t relevance_bits = 0U;
+    std::memcpy(&relevance_bits, &document.relevance, sizeof(relevance_bits));
+    return std::to_string(relevance_bits) + ':' + std::to_string(document.rating) + ':' + std::to_string(document.id);
+}
+
+Document SearchServer::DecodeContinuationToken(const std::string &token) {
+    std::istringstream input(token);
+    uint64_t relevance_bits = 0U;
+    Document document;
+    char rating_separator = 0;
+    char id_separator = 0;
+    if (!(input >> relevance_bits >> rating_separator >> document.rating >> id_separator >> document.id) ||
+        rating_separator != ':' || id_separator != ':' || input.peek() != std::istringstream::traits_type::eof()) {
+        throw std::invalid_argument("invalid continuation token: " + token);
+    }
+    std::memcpy(&document.relevance, &relevance_bits, sizeof(document.relevance));
+    return document;
+}
+
+bool SearchServer::IsValidWord(std::string_view word) {
     return std::none_of(word.begin(), word.end(), [](char ch) { return std::iscntrl(ch); });
 }
 
@@ -159,49 +588,202 @@ void SearchServer::CheckDocumentId(int document_id) const {
     if (document_id < 0) {
         throw std::invalid_argument("document_id must not be negative");
     }
-    if (storage_.count(document_id)) {
+    if (storage_.count(document_id) || duplicate_to_canonical_.count(document_id)) {
         throw std::invalid_argument("document_id already exists");
     }
 }
 
-std::set<int>::iterator SearchServer::begin() {
+SearchServer::SearchServer(std::pmr::memory_resource *resource)
+        : resource_(resource) {
+}
+
+std::pmr::set<int>::iterator SearchServer::begin() {
     return documents_.begin();
 }
 
-std::set<int>::iterator SearchServer::end() {
+std::pmr::set<int>::iterator SearchServer::end() {
     return documents_.end();
 }
 
-std::set<int>::const_iterator SearchServer::begin() const {
+std::pmr::set<int>::const_iterator SearchServer::begin() const {
     return documents_.cbegin();
 }
 
-std::set<int>::const_iterator SearchServer::end() const {
+std::pmr::set<int>::const_iterator SearchServer::end() const {
     return documents_.cend();
 }
 
-const std::map<std::string, double> &SearchServer::GetWordFrequencies(int document_id) const {
-    static const std::map<std::string, double> kEmptyMap{};
-    if (document_to_word_frequency_.count(document_id)) {
-        return document_to_word_frequency_.at(document_id);
+std::pmr::memory_resource *SearchServer::GetMemoryResource() const {
+    return resource_;
+}
+
+SearchServer::WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    if (removed_documents_.count(document_id)) {
+        return {};
+    }
+    return GetForwardEntries(document_id);
+}
+
+SearchServer::WordFrequencies SearchServer::GetForwardEntries(int document_id) const {
+    const auto kRunIt = document_to_forward_run_.find(document_id);
+    if (kRunIt == document_to_forward_run_.end()) {
+        return {};
     }
-    return kEmptyMap;
+    const ForwardEntry *kFirst = forward_index_.data() + kRunIt->second.offset;
+    return {kFirst, kFirst + kRunIt->second.size};
 }
 
 
 void SearchServer::RemoveDocument(int document_id) {
-    if (!documents_.count(document_id)) {
+    PROFILE_SCOPE("SearchServer::RemoveDocument");
+    if (UnlinkDuplicate(document_id) || !documents_.count(document_id)) {
         return;
     }
 
-    for (const auto&[word, _]: document_to_word_frequency_[document_id]) {
-        word_to_document_frequency_[word].erase(document_id);
-        if (word_to_document_frequency_[word].empty()) {
-            word_to_document_frequency_.erase(word);
+    ForgetFingerprint(document_id);
+    storage_.erase(document_id);
+    documents_.erase(document_id);
+    ++index_generation_;
+
+    if (removal_policy_ == RemovalPolicy::DEFERRED) {
+        TombstoneDocument(document_id);
+        return;
+    }
+
+    EraseDocumentPostings(document_id, std::numeric_limits<size_t>::max());
+    ShrinkForwardIndex();
+}
+
+void SearchServer::SetRemovalPolicy(RemovalPolicy policy) {
+    removal_policy_ = policy;
+}
+
+void SearchServer::SetAllocationPolicy(AllocationPolicy policy) {
+    if (policy == allocation_policy_) {
+        return;
+    }
+    allocation_policy_ = policy;
+    if (forward_index_garbage_ > 0U) {
+        CompactForwardIndex();
+    }
+    RebuildInvertedIndex();
+}
+
+size_t SearchServer::CompactRemovedDocuments(size_t posting_budget) {
+    size_t erased_postings = 0U;
+
+    while (!removed_documents_.empty() && erased_postings < posting_budget) {
+        const int kDocumentId = *removed_documents_.begin();
+        erased_postings += EraseDocumentPostings(kDocumentId, posting_budget - erased_postings);
+        if (document_to_forward_run_.count(kDocumentId)) {
+            break;
         }
+        removed_documents_.erase(removed_documents_.begin());
     }
+    ShrinkForwardIndex(posting_budget - erased_postings);
+    return erased_postings;
+}
 
-    storage_.erase(document_id);
-    documents_.erase(document_id);
-    document_to_word_frequency_.erase(document_id);
-}
\ No newline at end of file
+size_t SearchServer::GetRemovedDocumentCount() const {
+    return removed_documents_.size();
+}
+
+void SearchServer::TombstoneDocument(int document_id) {
+    removed_documents_.insert(document_id);
+    const auto kRunIt = document_to_forward_run_.find(document_id);
+    if (kRunIt == document_to_forward_run_.end()) {
+        return;
+    }
+    const ForwardRun kRun = kRunIt->second;
+    for (size_t i = kRun.offset; i < kRun.offset + kRun.size; ++i) {
+        ++forward_index_[i].term->second.tombstoned_count;
+    }
+}
+
+size_t SearchServer::EraseDocumentPostings(int document_id, size_t posting_budget) {
+    const auto kRunIt = document_to_forward_run_.find(document_id);
+    if (kRunIt == document_to_forward_run_.end()) {
+        return 0U;
+    }
+    ForwardRun &run = kRunIt->second;
+    const bool kIsTombstoned = removed_documents_.count(document_id) > 0U;
+    size_t erased_postings = 0U;
+
+    while (run.size > 0U && erased_postings < posting_budget) {
+        const Postings::iterator kTerm = forward_index_[run.offset].term;
+        kTerm->second.documents.erase(document_id);
+        if (kIsTombstoned) {
+            --kTerm->second.tombstoned_count;
+        }
+        if (kTerm->second.documents.empty()) {
+            EraseTerm(kTerm);
+        }
+        ++run.offset;
+        --run.size;
+        ++erased_postings;
+    }
+
+    forward_index_garbage_ += erased_postings;
+    if (run.size == 0U) {
+        document_to_forward_run_.erase(kRunIt);
+    }
+    return erased_postings;
+}
+
+bool SearchServer::CanFreePostingsConcurrently() const {
+    // a user resource may not be thread-safe, a monotonic arena never touches its upstream on deallocation
+    return allocation_policy_ == AllocationPolicy::ARENA || resource_ == std::pmr::new_delete_resource();
+}
+
+void SearchServer::EraseTerm(Postings::iterator term) {
+    const auto kStoredTerm = terms_.find(term->first);
+    inverted_index_->postings.erase(term);
+    terms_.erase(kStoredTerm);
+}
+
+void SearchServer::ShrinkForwardIndex(size_t work_budget) {
+    if (forward_index_garbage_ * 2U <= forward_index_.size()) {
+        return;
+    }
+    // every live entry is copied, under ARENA its posting is copied as well
+    const size_t kLiveEntries = forward_index_.size() - forward_index_garbage_;
+    if ((allocation_policy_ == AllocationPolicy::ARENA ? 2U * kLiveEntries : kLiveEntries) > work_budget) {
+        return;
+    }
+    CompactForwardIndex();
+    // erased nodes are never reused by an arena, so it is only freed by moving the live ones out
+    if (allocation_policy_ == AllocationPolicy::ARENA) {
+        RebuildInvertedIndex();
+    }
+}
+
+void SearchServer::CompactForwardIndex() {
+    std::pmr::vector<ForwardEntry> forward_index(resource_);
+    forward_index.reserve(forward_index_.size() - forward_index_garbage_);
+    for (auto &[_, run]: document_to_forward_run_) {
+        const auto kFirst = forward_index_.begin() + static_cast<std::ptrdiff_t>(run.offset);
+        run.offset = forward_index.size();
+        forward_index.insert(forward_index.end(), kFirst, kFirst + static_cast<std::ptrdiff_t>(run.size));
+    }
+    forward_index_.swap(forward_index);
+    forward_index_garbage_ = 0U;
+}
+
+SearchServer::InvertedIndex::InvertedIndex(AllocationPolicy policy, std::pmr::memory_resource *resource)
+        : arena(policy == AllocationPolicy::ARENA
+                ? std::make_unique<std::pmr::monotonic_buffer_resource>(1U << 16U, resource) : nullptr),
+          postings(arena ? arena.get() : resource) {
+}
+
+void SearchServer::RebuildInvertedIndex() {
+    auto rebuilt = std::make_unique<InvertedIndex>(allocation_policy_, resource_);
+    std::unordered_map<const Postings::value_type *, Postings::iterator> relocated_terms;
+    relocated_terms.reserve(inverted_index_->postings.size());
+    for (const auto &term: inverted_index_->postings) {
+        relocated_terms.emplace(&term, rebuilt->postings.emplace_hint(rebuilt->postings.end(), term));
+    }
+    for (ForwardEntry &entry: forward_index_) {
+        entry.term = relocated_terms.at(&*entry.term);
+    }
+    inverted_index_ = std::move(rebuilt);
+}
@@ -1,21 +1,239 @@
 #pragma once
 
 #include "document.h"
+#include "profiler.h"
 #include "string_processing.h"
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <set>
 #include <utility>
 #include <map>
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <execution>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
 
 
 class SearchServer {
+private:
+    // Documents of one term with their term frequencies. Postings of tombstoned documents stay until compaction,
+    // they are counted so that document frequencies of DEFERRED removal equal those of IMMEDIATE removal.
+    struct PostingList {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        explicit PostingList(const allocator_type &allocator) : documents(allocator) {}
+
+        PostingList(const PostingList &other, const allocator_type &allocator)
+                : documents(other.documents, allocator), tombstoned_count(other.tombstoned_count) {}
+
+        size_t GetLiveCount() const {
+            return documents.size() - tombstoned_count;
+        }
+
+        std::pmr::map<int, double> documents;
+        size_t tombstoned_count = 0U;
+    };
+
+    // Keys view the term store, which compaction never moves, so the views handed out outlive a rebuild
+    using Postings = std::pmr::map<std::string_view, PostingList, std::less<>>;
+
+    // A word of a document in the flat forward index, the postings node of the word serves as its term id
+    struct ForwardEntry {
+        Postings::iterator term;
+        double frequency;
+    };
+
 public:
     using Documents = std::vector<Document>;
 
+    // Read-only view of a document's run in the flat forward index, sorted by word.
+    // Valid until the next modification of the server.
+    class WordFrequencies {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::pair<std::string_view, double>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type *;
+            using reference = value_type;
+
+            // lets it->first work on the pair produced by value
+            class ArrowProxy {
+            public:
+                explicit ArrowProxy(value_type value) : value_(value) {}
+
+                pointer operator->() const {
+                    return &value_;
+                }
+
+            private:
+                value_type value_;
+            };
+
+            Iterator() = default;
+
+            explicit Iterator(const ForwardEntry *entry) : entry_(entry) {}
+
+            value_type operator*() const {
+                return {entry_->term->first, entry_->frequency};
+            }
+
+            ArrowProxy operator->() const {
+                return ArrowProxy(**this);
+            }
+
+            Iterator &operator++() {
+                ++entry_;
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator previous = *this;
+                ++entry_;
+                return previous;
+            }
+
+            bool operator==(const Iterator &other) const {
+                return entry_ == other.entry_;
+            }
+
+            bool operator!=(const Iterator &other) const {
+                return entry_ != other.entry_;
+            }
+
+        private:
+            const ForwardEntry *entry_ = nullptr;
+        };
+
+        WordFrequencies() = default;
+
+        WordFrequencies(const ForwardEntry *first, const ForwardEntry *last);
+
+        Iterator begin() const;
+
+        Iterator end() const;
+
+        size_t size() const;
+
+        bool empty() const;
+
+        Iterator find(std::string_view word) const;
+
+        size_t count(std::string_view word) const;
+
+    private:
+        const ForwardEntry *first_ = nullptr;
+        const ForwardEntry *last_ = nullptr;
+    };
+
+    // IMMEDIATE erases postings in RemoveDocument, DEFERRED only tombstones the document until compaction
+    enum class RemovalPolicy {
+        IMMEDIATE,
+        DEFERRED,
+    };
+
+    // What AddDocument does with a document whose word set equals the one of an indexed document.
+    // KEEP indexes it as usual, REJECT skips it, REPLACE removes the indexed one,
+    // LINK skips it and remembers the indexed one as its canonical document.
+    enum class DuplicatePolicy {
+        KEEP,
+        REJECT,
+        REPLACE,
+        LINK,
+    };
+
+    // HEAP allocates every posting node on its own. ARENA bump-allocates them from large chunks, which are freed
+    // at once when the server is destroyed or the index is compacted. Term strings come from the server's resource
+    // under both policies, so views of them survive compaction.
+    enum class AllocationPolicy {
+        HEAP,
+        ARENA,
+    };
+
+    // Estimated from container sizes and node layouts, excluding allocator overhead and dead arena nodes.
+    // Only the term dictionary and the stop words are walked, everything else is counted in O(1).
+    struct MemoryStats {
+        size_t term_count = 0U;
+        // tombstoned documents keep their postings until compaction
+        size_t posting_count = 0U;
+        size_t document_count = 0U;
+        double average_posting_length = 0.0;
+
+        size_t term_dictionary_bytes = 0U;
+        size_t postings_bytes = 0U;
+        size_t forward_index_bytes = 0U;
+        size_t document_metadata_bytes = 0U;
+        size_t stop_words_bytes = 0U;
+
+        size_t GetTotalBytes() const;
+    };
+
+    // Work done by one query, filled in only by the overloads that take it
+    struct QueryStats {
+        // query words found in the index, or looked up in the document by MatchDocument
+        size_t terms_resolved = 0U;
+        size_t postings_scanned = 0U;
+        size_t predicate_evaluations = 0U;
+        // distinct documents given a relevance before minus words are applied
+        size_t documents_scored = 0U;
+        size_t documents_excluded_by_minus_words = 0U;
+        size_t candidates_sorted = 0U;
+    };
+
+    // How FindAllDocuments evaluates a parsed query, chosen by PlanQuery
+    enum class QueryStrategy {
+        // no plus word is indexed, so nothing is scored or excluded
+        NO_MATCHING_TERMS,
+        // the postings of every plus word are summed per document, then minus word postings erase documents
+        TERM_AT_A_TIME,
+    };
+
+    struct QueryTermExplanation {
+        std::string word;
+        bool is_indexed = false;
+        // live documents containing the word
+        size_t document_frequency = 0U;
+        // the posting list also holds tombstoned documents until compaction, the IDF does not count them
+        size_t posting_list_length = 0U;
+        double inverse_document_frequency = 0.0;
+    };
+
+    struct QueryExplanation {
+        // sorted distinct words left after stop word removal
+        std::vector<QueryTermExplanation> plus_terms;
+        std::vector<QueryTermExplanation> minus_terms;
+        QueryStrategy strategy = QueryStrategy::NO_MATCHING_TERMS;
+        QueryStats stats;
+        std::vector<Document> documents;
+        std::chrono::nanoseconds parse_time{};
+        std::chrono::nanoseconds plan_time{};
+        std::chrono::nanoseconds score_time{};
+        std::chrono::nanoseconds sort_time{};
+    };
+
+    // One page of results ranked by exact relevance, then rating, then id.
+    // The token is empty on the last page, otherwise it resumes the search right after this page.
+    struct ResultPage {
+        std::vector<Document> documents;
+        std::string continuation_token;
+    };
+
+    // Distinct non-stop words of a document in sorted order with their term frequencies.
+    // Words point into the tokenized text.
+    using TokenizedDocument = std::vector<std::pair<std::string_view, double>>;
+
 public:
     const size_t kMaxResultDocumentSize = 5U;
     const char kMinusWordPrefix = '-';
@@ -23,28 +241,65 @@ public:
 public:
     SearchServer() = default;
 
+    // Every container of the server allocates from the resource, and so does query scratch that outgrows
+    // its stack buffer. Concurrent queries therefore need a thread-safe resource.
+    explicit SearchServer(std::pmr::memory_resource *resource);
+
     template<typename StringContainer>
-    explicit SearchServer(const StringContainer &stop_words)
-            : stop_words_(stop_words.begin(), stop_words.end()) {
+    explicit SearchServer(const StringContainer &stop_words,
+                          std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : resource_(resource), stop_words_(stop_words.begin(), stop_words.end(), resource) {
         CheckWords(stop_words_);
     }
 
-    explicit SearchServer(const std::string &stop_words_text)
-            : SearchServer(SplitIntoWords(stop_words_text)) {}
+    explicit SearchServer(const std::string &stop_words_text,
+                          std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : SearchServer(SplitIntoWords(stop_words_text), resource) {}
+
+    // The forward index points into the server's own posting lists, so a server cannot be copied.
+    // Members keep their memory resource on assignment, so it cannot be move assigned either.
+    SearchServer(const SearchServer &) = delete;
 
-    std::set<int>::iterator begin();
+    SearchServer(SearchServer &&) = default;
 
-    std::set<int>::iterator end();
+    SearchServer &operator=(const SearchServer &) = delete;
 
-    std::set<int>::const_iterator begin() const;
+    SearchServer &operator=(SearchServer &&) = delete;
 
-    std::set<int>::const_iterator end() const;
+    std::pmr::set<int>::iterator begin();
+
+    std::pmr::set<int>::iterator end();
+
+    std::pmr::set<int>::const_iterator begin() const;
+
+    std::pmr::set<int>::const_iterator end() const;
+
+    std::pmr::memory_resource *GetMemoryResource() const;
 
 public:
     void SetStopWords(const std::string &text);
 
-    void AddDocument(int document_id, const std::string &document, DocumentStatus status,
-                     const std::vector<int> &ratings);
+    // Returns the id the document content is indexed under, which differs from document_id
+    // only for a duplicate skipped by the REJECT or LINK policy
+    int AddDocument(int document_id, const std::string &document, DocumentStatus status,
+                    const std::vector<int> &ratings);
+
+    // AddDocument split in two stages. Tokenizing reads only the stop words, so it may run on another thread
+    // while documents are added, as long as SetStopWords is not called meanwhile.
+    TokenizedDocument TokenizeDocument(std::string_view document) const;
+
+    // word_frequencies must come from TokenizeDocument of this server, only words new to the index are copied
+    int AddTokenizedDocument(int document_id, const TokenizedDocument &word_frequencies, DocumentStatus status,
+                             const std::vector<int> &ratings);
+
+    void SetDuplicatePolicy(DuplicatePolicy policy);
+
+    // The canonical document of a linked duplicate, the id itself for any other id
+    int GetCanonicalDocumentId(int document_id) const;
+
+    // Order-dependent hash of a sorted word set, equal word sets have equal fingerprints
+    template<typename WordFrequencyRange>
+    static uint64_t ComputeWordSetFingerprint(const WordFrequencyRange &word_frequencies);
 
     template<typename Predicate>
     Documents FindTopDocuments(const std::string &raw_query, Predicate predicate) const;
@@ -53,15 +308,91 @@ public:
 
     std::vector<Document> FindTopDocuments(const std::string &raw_query) const;
 
+    // Same as above, and adds the work done to stats
+    template<typename Predicate>
+    Documents FindTopDocuments(const std::string &raw_query, Predicate predicate, QueryStats &stats) const;
+
+    std::vector<Document> FindTopDocuments(const std::string &raw_query, DocumentStatus status,
+                                           QueryStats &stats) const;
+
+    std::vector<Document> FindTopDocuments(const std::string &raw_query, QueryStats &stats) const;
+
+    // Runs the query as FindTopDocuments(raw_query) does, phase by phase, and reports the plan, terms and costs
+    QueryExplanation ExplainQuery(const std::string &raw_query) const;
+
+    // Only documents ranked after the token are sorted, so a deep page costs about as much as the first one
+    template<typename Predicate>
+    ResultPage FindTopDocumentsPage(const std::string &raw_query, Predicate predicate, size_t page_size,
+                                    const std::string &continuation_token = {}) const;
+
+    ResultPage FindTopDocumentsPage(const std::string &raw_query, DocumentStatus status, size_t page_size,
+                                    const std::string &continuation_token = {}) const;
+
+    ResultPage FindTopDocumentsPage(const std::string &raw_query, size_t page_size,
+                                    const std::string &continuation_token = {}) const;
+
     size_t GetDocumentCount() const;
 
-    const std::map<std::string, double> &GetWordFrequencies(int document_id) const;
+    MemoryStats GetMemoryStats() const;
+
+    // Changes whenever the index changes in a way that can change search results
+    uint64_t GetIndexGeneration() const;
+
+    // Sorted distinct plus words followed by sorted distinct minus words, stop words dropped
+    std::string GetNormalizedQuery(const std::string &raw_query) const;
+
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
     void RemoveDocument(int document_id);
 
+    // Groups postings of all removed documents by word, so every posting list is visited once
+    template<typename DocumentIds>
+    void RemoveDocuments(const DocumentIds &document_ids);
+
+    // Posting lists of different words are independent, a parallel policy cleans them concurrently. Their nodes are
+    // then freed from several threads, so the cleanup runs sequentially unless the server allocates from
+    // std::pmr::new_delete_resource() or an ARENA, whose frees do nothing.
+    template<typename ExecutionPolicy, typename DocumentIds>
+    void RemoveDocuments(ExecutionPolicy &&policy, const DocumentIds &document_ids);
+
+    void SetRemovalPolicy(RemovalPolicy policy);
+
+    // Moves the posting lists to the memory of the new policy, term strings stay where they are
+    void SetAllocationPolicy(AllocationPolicy policy);
+
+    // Erases at most posting_budget postings of tombstoned documents, returns the number of erased postings.
+    // Once erased entries outnumber live ones, the forward index is compacted, and under ARENA the posting lists
+    // are rebuilt. That copies every live posting, one unit of the budget each and two under ARENA, so it runs
+    // only if the budget left after erasing covers it. Budgeted slices never stall on it, a later larger budget
+    // or a call without one reclaims the memory.
+    // Tombstoned documents are already out of every result, so the index generation stays the same.
+    size_t CompactRemovedDocuments(size_t posting_budget = std::numeric_limits<size_t>::max());
+
+    size_t GetRemovedDocumentCount() const;
+
     std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string &raw_query,
                                                                        int document_id) const;
 
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy &,
+                                                                       const std::string &raw_query,
+                                                                       int document_id) const;
+
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::execution::parallel_policy &,
+                                                                       const std::string &raw_query,
+                                                                       int document_id) const;
+
+    // Matched words point into the server's own term storage and stay valid until the document is removed
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocumentView(const std::string &raw_query,
+                                                                                int document_id) const;
+
+    // Same as MatchDocumentView, but reuses the caller's buffer, which is cleared first
+    DocumentStatus MatchDocument(const std::string &raw_query, int document_id,
+                                 std::vector<std::string_view> &matched_words) const;
+
+    // Same as MatchDocument, and adds the work done to stats
+    DocumentStatus MatchDocument(const std::string &raw_query, int document_id,
+                                 std::vector<std::string_view> &matched_words, QueryStats &stats) const;
+
 private:
     struct DocumentData {
         int rating;
@@ -76,6 +407,12 @@ private:
 
     QueryWord ParseQueryWord(std::string text) const;
 
+    // Plus and minus words in query order, neither sorted nor deduplicated
+    struct QueryWords {
+        std::vector<std::string> plus_words;
+        std::vector<std::string> minus_words;
+    };
+
     class Query {
     public:
         const std::set<std::string> &GetPlusWords() const;
@@ -91,81 +428,423 @@ private:
         std::set<std::string> minus_words_;
     };
 
+    // [offset, offset + size) of a document in the flat forward index
+    struct ForwardRun {
+        size_t offset;
+        size_t size;
+    };
+
+    // The posting lists keyed by views of the term store, replaced as a whole to free an arena at once
+    struct InvertedIndex {
+        InvertedIndex(AllocationPolicy policy, std::pmr::memory_resource *resource);
+
+        // declared first, so it outlives the postings allocated from it
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+        Postings postings;
+    };
+
+    // An indexed query word with its posting list
+    struct PlannedTerm {
+        Postings::const_iterator term;
+        double inverse_document_frequency;
+    };
+
+    struct QueryPlan {
+        explicit QueryPlan(std::pmr::memory_resource *resource);
+
+        QueryStrategy strategy = QueryStrategy::NO_MATCHING_TERMS;
+        // in query order, words missing from the index are left out
+        std::pmr::vector<PlannedTerm> plus_terms;
+        std::pmr::vector<PlannedTerm> minus_terms;
+    };
+
+    struct PostingRemoval {
+        Postings::iterator word_it;
+        size_t first;
+        size_t last;
+    };
+
 private:
-    bool IsStopWord(const std::string &word) const;
+    bool IsStopWord(std::string_view word) const;
 
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string &text) const;
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
 
     static int ComputeAverageRating(const std::vector<int> &ratings);
 
+    QueryWords ParseQueryWords(const std::string &text) const;
+
     Query ParseQuery(const std::string &text) const;
 
-    double ComputeWordInverseDocumentFrequency(const std::string &word) const;
+    double ComputeInverseDocumentFrequency(size_t document_frequency) const;
 
-    template<typename Predicate>
-    std::vector<Document> FindAllDocuments(const Query &query, Predicate predicate) const;
+    QueryPlan PlanQuery(const Query &query, std::pmr::memory_resource *resource) const;
+
+    template<typename Predicate, typename Stats>
+    void ScoreDocuments(const QueryPlan &plan, Predicate predicate, Stats &stats,
+                        std::pmr::map<int, double> &document_to_relevance) const;
+
+    // Sorts by relevance and keeps the first kMaxResultDocumentSize
+    void SelectTopDocuments(std::vector<Document> &documents) const;
+
+    QueryTermExplanation ExplainTerm(const std::string &word) const;
+
+    // Stats type of the uninstrumented paths, its counting compiles out
+    struct NoQueryStats {
+    };
+
+    // Adds amount to the counter, nothing for NoQueryStats
+    template<typename Stats>
+    static void Count(Stats &stats, size_t QueryStats::*counter, size_t amount = 1U);
+
+    template<typename Predicate, typename Stats>
+    Documents FindTopDocumentsWithStats(const std::string &raw_query, Predicate predicate, Stats &stats) const;
+
+    template<typename Predicate, typename Stats>
+    std::vector<Document> FindAllDocuments(const Query &query, Predicate predicate, Stats &stats) const;
+
+    template<typename Stats>
+    DocumentStatus MatchDocumentWithStats(const std::string &raw_query, int document_id,
+                                          std::vector<std::string_view> &matched_words, Stats &stats) const;
+
+    // Writes the forward index words of a document that are present in the sorted range [first, last)
+    template<typename InputIt, typename OutputIt>
+    static OutputIt IntersectWithDocument(InputIt first, InputIt last,
+                                          const WordFrequencies &word_frequencies, OutputIt out);
+
+    std::vector<Document> MakeDocuments(const std::pmr::map<int, double> &document_to_relevance) const;
+
+    // Exact relevance, then rating, then id. Unlike the tolerant operator< of Document it is transitive,
+    // as sorting and cursor filtering require, so relevances within 1e-6 may be ordered apart from FindTopDocuments.
+    static bool IsRankedBefore(const Document &left, const Document &right);
 
-    std::vector<Document> MakeDocuments(const std::map<int, double> &document_to_relevance) const;
+    // The token stores the exact relevance bits, rating and id of the last document of a page
+    static std::string EncodeContinuationToken(const Document &document);
 
-    static bool IsValidWord(const std::string &word);
+    static Document DecodeContinuationToken(const std::string &token);
+
+    static bool IsValidWord(std::string_view word);
 
     template<typename Container>
-    static void CheckWords(Container words) {
+    static void CheckWords(const Container &words) {
         for (const auto &word: words) {
             if (!IsValidWord(word)) {
-                throw std::invalid_argument("invalid word: " + word);
+                throw std::invalid_argument("invalid word: " + std::string(word));
             }
         }
     }
 
     void CheckDocumentId(int document_id) const;
 
+    std::optional<int> FindDocumentWithSameWords(uint64_t fingerprint,
+                                                 const TokenizedDocument &word_frequencies) const;
+
+    // Forward index words of the document, tombstoned or not
+    WordFrequencies GetForwardEntries(int document_id) const;
+
+    // Forgets a duplicate skipped by the LINK policy, returns false for any other id
+    bool UnlinkDuplicate(int document_id);
+
+    void RegisterFingerprint(int document_id);
+
+    // Drops the document from the fingerprint table and unlinks its duplicates, called before it leaves the index
+    void ForgetFingerprint(int document_id);
+
+    // Keeps the postings of a removed document until compaction, but drops them from document frequencies
+    void TombstoneDocument(int document_id);
+
+    // Erases postings of the document one forward index word at a time, drops its forward entry once it is empty.
+    // Leaves shrinking to the caller.
+    size_t EraseDocumentPostings(int document_id, size_t posting_budget);
+
+    // Whether posting nodes may be freed from several threads at once
+    bool CanFreePostingsConcurrently() const;
+
+    // Drops a term whose posting list became empty from the index and the term store
+    void EraseTerm(Postings::iterator term);
+
+    // Compacts the flat forward index once erased entries outnumber live ones, rebuilds an arena along with it.
+    // Does nothing if the copying costs more than work_budget.
+    void ShrinkForwardIndex(size_t work_budget = std::numeric_limits<size_t>::max());
+
+    // Moves live runs to the front of the flat forward index
+    void CompactForwardIndex();
+
+    // Copies postings into a fresh InvertedIndex of the current policy and repoints the forward index.
+    // The forward index must hold no erased entries.
+    void RebuildInvertedIndex();
+
 private:
-    std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_frequency_;
-    std::map<int, std::map<std::string, double>> document_to_word_frequency_;
-    std::map<int, DocumentData> storage_;
-    std::set<int> documents_;
+    // bytes of query scratch kept on the stack before the resource is asked for more
+    static constexpr size_t kQueryScratchBufferSize = 4096U;
+
+    // declared first, every other member allocates from it
+    std::pmr::memory_resource *resource_ = std::pmr::get_default_resource();
+    std::pmr::set<std::pmr::string, std::less<>> stop_words_{resource_};
+    AllocationPolicy allocation_policy_ = AllocationPolicy::HEAP;
+    // every indexed word, declared before the index that views it
+    std::pmr::set<std::pmr::string, std::less<>> terms_{resource_};
+    std::unique_ptr<InvertedIndex> inverted_index_ = std::make_unique<InvertedIndex>(AllocationPolicy::HEAP,
+                                                                                     resource_);
+    std::pmr::vector<ForwardEntry> forward_index_{resource_};
+    std::pmr::map<int, ForwardRun> document_to_forward_run_{resource_};
+    size_t forward_index_garbage_ = 0U;
+    std::pmr::map<int, DocumentData> storage_{resource_};
+    std::pmr::set<int> documents_{resource_};
+    std::pmr::set<int> removed_documents_{resource_};
+    RemovalPolicy removal_policy_ = RemovalPolicy::IMMEDIATE;
+    DuplicatePolicy duplicate_policy_ = DuplicatePolicy::KEEP;
+    uint64_t index_generation_ = 0U;
+    std::pmr::unordered_map<uint64_t, std::pmr::vector<int>> fingerprint_to_documents_{resource_};
+    std::pmr::map<int, int> duplicate_to_canonical_{resource_};
+    std::pmr::map<int, std::pmr::vector<int>> canonical_to_duplicates_{resource_};
 };
 
 template<typename Predicate>
 SearchServer::Documents SearchServer::FindTopDocuments(const std::string &raw_query, Predicate predicate) const {
-    const Query kQuery = ParseQuery(raw_query);
+    NoQueryStats stats;
+    return FindTopDocumentsWithStats(raw_query, predicate, stats);
+}
 
-    auto matched_documents = FindAllDocuments(kQuery, predicate);
-    sort(matched_documents.begin(), matched_documents.end());
+template<typename Predicate>
+SearchServer::Documents SearchServer::FindTopDocuments(const std::string &raw_query, Predicate predicate,
+                                                       QueryStats &stats) const {
+    return FindTopDocumentsWithStats(raw_query, predicate, stats);
+}
 
-    if (matched_documents.size() > kMaxResultDocumentSize) {
-        matched_documents.resize(kMaxResultDocumentSize);
+template<typename Stats>
+void SearchServer::Count(Stats &stats, size_t QueryStats::*counter, size_t amount) {
+    if constexpr (std::is_same_v<Stats, QueryStats>) {
+        stats.*counter += amount;
     }
+}
+
+template<typename Predicate, typename Stats>
+SearchServer::Documents SearchServer::FindTopDocumentsWithStats(const std::string &raw_query, Predicate predicate,
+                                                                Stats &stats) const {
+    PROFILE_SCOPE("SearchServer::FindTopDocuments");
+    const Query kQuery = ParseQuery(raw_query);
 
+    auto matched_documents = FindAllDocuments(kQuery, predicate, stats);
+    Count(stats, &QueryStats::candidates_sorted, matched_documents.size());
+    SelectTopDocuments(matched_documents);
     return matched_documents;
 }
 
 template<typename Predicate>
-std::vector<Document> SearchServer::FindAllDocuments(const SearchServer::Query &query, Predicate predicate) const {
-    std::map<int, double> document_to_relevance;
+SearchServer::ResultPage SearchServer::FindTopDocumentsPage(const std::string &raw_query, Predicate predicate,
+                                                            size_t page_size,
+                                                            const std::string &continuation_token) const {
+    if (page_size == 0U) {
+        throw std::invalid_argument("Page size must be positive");
+    }
+    const std::optional<Document> kCursor = continuation_token.empty()
+                                            ? std::nullopt
+                                            : std::make_optional(DecodeContinuationToken(continuation_token));
+
+    NoQueryStats stats;
+    auto matched_documents = FindAllDocuments(ParseQuery(raw_query), predicate, stats);
+    if (kCursor) {
+        matched_documents.erase(std::remove_if(matched_documents.begin(), matched_documents.end(),
+                                               [&kCursor](const Document &document) {
+                                                   return !IsRankedBefore(*kCursor, document);
+                                               }),
+                                matched_documents.end());
+    }
 
-    for (const std::string &word: query.GetPlusWords()) {
-        if (word_to_document_frequency_.count(word) == 0U) {
-            continue;
-        }
-        const double kInverseDocumentFreq = ComputeWordInverseDocumentFrequency(word);
-        for (const auto[kDocumentId, kTermFreq]: word_to_document_frequency_.at(word)) {
-            const auto &kDocumentData = storage_.at(kDocumentId);
+    const size_t kPageSize = std::min(page_size, matched_documents.size());
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + kPageSize, matched_documents.end(),
+                      &IsRankedBefore);
+
+    ResultPage page;
+    if (matched_documents.size() > kPageSize) {
+        page.continuation_token = EncodeContinuationToken(matched_documents[kPageSize - 1U]);
+    }
+    matched_documents.resize(kPageSize);
+    page.documents = std::move(matched_documents);
+    return page;
+}
+
+template<typename Predicate, typename Stats>
+std::vector<Document> SearchServer::FindAllDocuments(const SearchServer::Query &query, Predicate predicate,
+                                                     Stats &stats) const {
+    std::array<std::byte, kQueryScratchBufferSize> scratch_buffer;
+    std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource_);
+    const QueryPlan kPlan = PlanQuery(query, &scratch);
+    std::pmr::map<int, double> document_to_relevance(&scratch);
+    ScoreDocuments(kPlan, predicate, stats, document_to_relevance);
+    return MakeDocuments(document_to_relevance);
+}
+
+template<typename Predicate, typename Stats>
+void SearchServer::ScoreDocuments(const QueryPlan &plan, Predicate predicate, Stats &stats,
+                                  std::pmr::map<int, double> &document_to_relevance) const {
+    if (plan.strategy == QueryStrategy::NO_MATCHING_TERMS) {
+        return;
+    }
+
+    for (const PlannedTerm &plus_term: plan.plus_terms) {
+        Count(stats, &QueryStats::terms_resolved);
+        Count(stats, &QueryStats::postings_scanned, plus_term.term->second.documents.size());
+        for (const auto[kDocumentId, kTermFreq]: plus_term.term->second.documents) {
+            const auto kDocumentIt = storage_.find(kDocumentId);
+            if (kDocumentIt == storage_.end()) {
+                continue; // tombstoned, waits for compaction
+            }
+            const auto &kDocumentData = kDocumentIt->second;
+            Count(stats, &QueryStats::predicate_evaluations);
             if (predicate(kDocumentId, kDocumentData.status, kDocumentData.rating)) {
-                document_to_relevance[kDocumentId] += kTermFreq * kInverseDocumentFreq;
+                document_to_relevance[kDocumentId] += kTermFreq * plus_term.inverse_document_frequency;
             }
         }
     }
 
-    for (const std::string &word: query.GetMinusWords()) {
-        if (word_to_document_frequency_.count(word) == 1U) {
-            for (const auto[kDocumentId, _]: word_to_document_frequency_.at(word)) {
-                document_to_relevance.erase(kDocumentId);
+    Count(stats, &QueryStats::documents_scored, document_to_relevance.size());
+
+    for (const PlannedTerm &minus_term: plan.minus_terms) {
+        Count(stats, &QueryStats::terms_resolved);
+        Count(stats, &QueryStats::postings_scanned, minus_term.term->second.documents.size());
+        for (const auto[kDocumentId, _]: minus_term.term->second.documents) {
+            Count(stats, &QueryStats::documents_excluded_by_minus_words, document_to_relevance.erase(kDocumentId));
+        }
+    }
+}
+
+template<typename Stats>
+DocumentStatus SearchServer::MatchDocumentWithStats(const std::string &raw_query, int document_id,
+                                                    std::vector<std::string_view> &matched_words,
+                                                    Stats &stats) const {
+    PROFILE_SCOPE("SearchServer::MatchDocument");
+    const Query kQuery = ParseQuery(raw_query);
+    const DocumentStatus kStatus = storage_.at(document_id).status;
+    const auto &kWordFrequencies = GetWordFrequencies(document_id);
+    matched_words.clear();
+
+    const auto &kMinusWords = kQuery.GetMinusWords();
+    if (std::any_of(kMinusWords.begin(), kMinusWords.end(), [&kWordFrequencies, &stats](const std::string &word) {
+        Count(stats, &QueryStats::terms_resolved);
+        return kWordFrequencies.count(word) > 0U;
+    })) {
+        Count(stats, &QueryStats::documents_excluded_by_minus_words);
+        return kStatus;
+    }
+
+    const auto &kPlusWords = kQuery.GetPlusWords();
+    Count(stats, &QueryStats::terms_resolved, kPlusWords.size());
+    IntersectWithDocument(kPlusWords.begin(), kPlusWords.end(), kWordFrequencies, std::back_inserter(matched_words));
+
+    return kStatus;
+}
+
+template<typename WordFrequencyRange>
+uint64_t SearchServer::ComputeWordSetFingerprint(const WordFrequencyRange &word_frequencies) {
+    uint64_t fingerprint = word_frequencies.size();
+    for (const auto &[word, _]: word_frequencies) {
+        const uint64_t kWordHash = std::hash<std::string_view>{}(word);
+        fingerprint ^= kWordHash + 0x9e3779b97f4a7c15ULL + (fingerprint << 6U) + (fingerprint >> 2U);
+    }
+    return fingerprint;
+}
+
+template<typename InputIt, typename OutputIt>
+OutputIt SearchServer::IntersectWithDocument(InputIt first, InputIt last,
+                                             const WordFrequencies &word_frequencies, OutputIt out) {
+    const auto kWordsCount = static_cast<size_t>(std::distance(first, last));
+    const auto kLookupCost = static_cast<size_t>(std::log2(word_frequencies.size() + 1U)) + 1U;
+
+    // a short query against a long document: a lookup per word is cheaper than a full merge
+    if (kWordsCount * kLookupCost < word_frequencies.size()) {
+        for (; first != last; ++first) {
+            const auto kIt = word_frequencies.find(*first);
+            if (kIt != word_frequencies.end()) {
+                *out++ = kIt->first;
             }
         }
+        return out;
     }
 
-    return MakeDocuments(document_to_relevance);
+    auto document_it = word_frequencies.begin();
+    while (first != last && document_it != word_frequencies.end()) {
+        if (*first < document_it->first) {
+            ++first;
+        } else if (document_it->first < *first) {
+            ++document_it;
+        } else {
+            *out++ = document_it->first;
+            ++first;
+            ++document_it;
+        }
+    }
+    return out;
+}
+
+template<typename DocumentIds>
+void SearchServer::RemoveDocuments(const DocumentIds &document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+template<typename ExecutionPolicy, typename DocumentIds>
+void SearchServer::RemoveDocuments(ExecutionPolicy &&policy, const DocumentIds &document_ids) {
+    std::vector<int> removed_ids;
+    for (const int kDocumentId: document_ids) {
+        if (!UnlinkDuplicate(kDocumentId) && documents_.erase(kDocumentId)) {
+            ForgetFingerprint(kDocumentId);
+            storage_.erase(kDocumentId);
+            removed_ids.push_back(kDocumentId);
+        }
+    }
+
+    if (!removed_ids.empty()) {
+        ++index_generation_;
+    }
+
+    if (removal_policy_ == RemovalPolicy::DEFERRED) {
+        for (const int kDocumentId: removed_ids) {
+            TombstoneDocument(kDocumentId);
+        }
+        return;
+    }
+
+    std::vector<std::pair<Postings::iterator, int>> term_documents;
+    for (const int kDocumentId: removed_ids) {
+        const ForwardRun kRun = document_to_forward_run_.at(kDocumentId);
+        for (size_t i = kRun.offset; i < kRun.offset + kRun.size; ++i) {
+            term_documents.emplace_back(forward_index_[i].term, kDocumentId);
+        }
+    }
+    std::sort(policy, term_documents.begin(), term_documents.end(), [](const auto &left, const auto &right) {
+        return std::less<>{}(&*left.first, &*right.first);
+    });
+
+    std::vector<PostingRemoval> removals;
+    for (size_t first = 0U; first < term_documents.size();) {
+        size_t last = first + 1U;
+        while (last < term_documents.size() && term_documents[last].first == term_documents[first].first) {
+            ++last;
+        }
+        removals.push_back({term_documents[first].first, first, last});
+        first = last;
+    }
+
+    const auto kErasePostings = [&term_documents](const PostingRemoval &removal) {
+        for (size_t i = removal.first; i < removal.last; ++i) {
+            removal.word_it->second.documents.erase(term_documents[i].second);
+        }
+    };
+    if (CanFreePostingsConcurrently()) {
+        std::for_each(policy, removals.begin(), removals.end(), kErasePostings);
+    } else {
+        std::for_each(removals.begin(), removals.end(), kErasePostings);
+    }
+
+    for (const PostingRemoval &removal: removals) {
+        if (removal.word_it->second.documents.empty()) {
+            EraseTerm(removal.word_it);
+        }
+    }
+    for (const int kDocumentId: removed_ids) {
+        const auto kRunIt = document_to_forward_run_.find(kDocumentId);
+        forward_index_garbage_ += kRunIt->second.size;
+        document_to_forward_run_.erase(kRunIt);
+    }
+    ShrinkForwardIndex();
 }
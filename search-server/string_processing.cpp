@@ -2,13 +2,19 @@
 
 
 std::vector<std::string> SplitIntoWords(const std::string &text) {
-    std::vector<std::string> words;
-    std::istringstream is(text);
+    const std::vector<std::string_view> kWords = SplitIntoWordsView(text);
+    return {kWords.begin(), kWords.end()};
+}
 
-    std::string word;
-    while (getline(is, word, ' ')) {
-        words.push_back(word);
+std::vector<std::string_view> SplitIntoWordsView(std::string_view text) {
+    std::vector<std::string_view> words;
+
+    // every space ends a word, possibly an empty one, the text end only ends a non-empty word
+    while (!text.empty()) {
+        const size_t kSpace = text.find(' ');
+        words.push_back(text.substr(0U, kSpace));
+        text.remove_prefix(kSpace == std::string_view::npos ? text.size() : kSpace + 1U);
     }
 
     return words;
-}
\ No newline at end of file
+}
@@ -2,7 +2,11 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <sstream>
 
 
 std::vector<std::string> SplitIntoWords(const std::string &text);
+
+// Same words as SplitIntoWords, pointing into text
+std::vector<std::string_view> SplitIntoWordsView(std::string_view text);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "test_framework.h"
+#include "corpus_ingestion.h"
+
+#include <sstream>
+
+
+using namespace std;
+
+IngestionOptions MakeQuietIngestionOptions() {
+    IngestionOptions options;
+    // tiny reads and batches put line and batch boundaries everywhere
+    options.read_buffer_size = 5U;
+    options.batch_size = 2U;
+    options.queue_capacity = 1U;
+    options.progress_output = nullptr;
+    return options;
+}
+
+void TestParseCorpusLine() {
+    const string kLine = "7\t2\t1 -3  8\tfunny pet\twith tab\r"s;
+    const auto kRecord = ParseCorpusLine(kLine, 1U);
+    ASSERT_EQUAL(kRecord.id, 7);
+    ASSERT_EQUAL(static_cast<int>(kRecord.status), static_cast<int>(DocumentStatus::BANNED));
+    const vector<int> kRatings = {1, -3, 8};
+    ASSERT_EQUAL(kRecord.ratings, kRatings);
+    ASSERT_EQUAL(string(kRecord.text), "funny pet\twith tab"s);
+
+    ASSERT(ParseCorpusLine("1\t0\t\t"s, 1U).ratings.empty());
+    CheckThrow<invalid_argument>([]() { ParseCorpusLine("1\t0\tcat"s, 1U); });
+    CheckThrow<invalid_argument>([]() { ParseCorpusLine("x\t0\t\tcat"s, 1U); });
+    CheckThrow<invalid_argument>([]() { ParseCorpusLine("1\t9\t\tcat"s, 1U); });
+    CheckThrow<invalid_argument>([]() { ParseCorpusLine("1\t0\t5x\tcat"s, 1U); });
+}
+
+void TestIngestCorpus() {
+    istringstream input("1\t0\t1 2 3\tfunny pet and nasty rat\n"
+                        "\n"
+                        "2\t2\t\tcurly hair\r\n"
+                        "3\t0\t4\tcurly cat with curly tail"s);
+    const size_t kBytes = input.str().size();
+
+    SearchServer server("and with"s);
+    const auto kStats = IngestCorpus(server, input, MakeQuietIngestionOptions());
+
+    ASSERT_EQUAL(kStats.documents, 3U);
+    ASSERT_EQUAL(kStats.bytes, kBytes);
+    ASSERT_EQUAL(server.GetDocumentCount(), 3U);
+
+    const auto kFound = server.FindTopDocuments("curly"s);
+    ASSERT_EQUAL(kFound.size(), 1U);
+    ASSERT_EQUAL(kFound[0].id, 3);
+    ASSERT_EQUAL(kFound[0].rating, 4);
+    ASSERT_EQUAL(server.FindTopDocuments("rat"s)[0].rating, 2);
+    ASSERT_EQUAL(server.FindTopDocuments("hair"s, DocumentStatus::BANNED).size(), 1U);
+}
+
+void TestIngestCorpusErrors() {
+    // the bad line sits behind many full batches, so every queue is full when the pipeline stops
+    string corpus;
+    for (int id = 1; id <= 1000; ++id) {
+        corpus += to_string(id) + "\t0\t\tcat\n"s;
+    }
+    {
+        istringstream input(corpus + "1\t0\t\tdog\n"s + corpus);
+        SearchServer server;
+        CheckThrow<invalid_argument>([&]() { IngestCorpus(server, input, MakeQuietIngestionOptions()); });
+    }
+    {
+        istringstream input("1\t0\t\tcat\nbad line\n"s + corpus);
+        SearchServer server;
+        CheckThrow<invalid_argument>([&]() { IngestCorpus(server, input, MakeQuietIngestionOptions()); });
+    }
+    SearchServer server;
+    CheckThrow<runtime_error>([&server]() { IngestCorpus(server, "/nonexistent/corpus.tsv"s); });
+}
+
+void TestIngestCorpusProgress() {
+    istringstream input("1\t0\t\tcat\n2\t0\t\tdog\n"s);
+    ostringstream progress;
+    IngestionOptions options = MakeQuietIngestionOptions();
+    options.batch_size = 1U;
+    options.report_interval = chrono::milliseconds(0);
+    options.progress_output = &progress;
+
+    SearchServer server;
+    IngestCorpus(server, input, options);
+    ASSERT(progress.str().find("Indexed 1 documents"s) != string::npos);
+    ASSERT(progress.str().find("Indexed 2 documents in"s) != string::npos);
+    ASSERT(progress.str().find("docs/sec"s) != string::npos);
+}
+
+void TestCorpusIngestion() {
+    RUN_TEST(TestParseCorpusLine);
+    RUN_TEST(TestIngestCorpus);
+    RUN_TEST(TestIngestCorpusErrors);
+    RUN_TEST(TestIngestCorpusProgress);
+    std::cerr << std::endl;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "test_framework.h"
+#include "histogram.h"
+
+
+void TestHistogramPercentiles() {
+    LogHistogram histogram;
+    ASSERT_EQUAL(histogram.GetP50(), 0U);
+
+    for (uint64_t value = 1U; value <= 1000U; ++value) {
+        histogram.Record(value);
+    }
+
+    ASSERT_EQUAL(histogram.GetCount(), 1000U);
+    ASSERT(histogram.GetP50() >= 500U && histogram.GetP50() <= 500U + 500U / 16U);
+    ASSERT(histogram.GetP90() >= 900U && histogram.GetP90() <= 900U + 900U / 16U);
+    ASSERT(histogram.GetP99() >= 990U && histogram.GetP99() <= 990U + 990U / 16U);
+    ASSERT(histogram.GetP999() >= 999U && histogram.GetP999() <= 999U + 999U / 16U);
+    ASSERT_EQUAL(histogram.GetPercentile(0.0), 1U);
+}
+
+void TestHistogramMerge() {
+    LogHistogram fast;
+    LogHistogram slow;
+    fast.Record(10U, 99U);
+    slow.Record(uint64_t{1} << 40U);
+
+    fast.Merge(slow);
+
+    ASSERT_EQUAL(fast.GetCount(), 100U);
+    ASSERT_EQUAL(fast.GetP99(), 10U);
+    ASSERT(fast.GetP999() >= uint64_t{1} << 40U);
+
+    fast.Reset();
+    ASSERT_EQUAL(fast.GetCount(), 0U);
+}
+
+void TestHistogram() {
+    RUN_TEST(TestHistogramPercentiles);
+    RUN_TEST(TestHistogramMerge);
+    std::cerr << std::endl;
+}
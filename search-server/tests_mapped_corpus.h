@@ -0,0 +1,110 @@
+#pragma once
+
+#include "test_framework.h"
+#include "mapped_corpus.h"
+
+#include <filesystem>
+#include <fstream>
+
+
+using namespace std;
+
+// Writes the text to a fresh file in the temporary directory and removes it when the test ends
+class TemporaryCorpusFile {
+public:
+    explicit TemporaryCorpusFile(const string &text)
+            : path_(filesystem::temp_directory_path() /
+                    ("search-server-corpus-"s + to_string(reinterpret_cast<uintptr_t>(this)) + ".tsv"s)) {
+        ofstream(path_, ios::binary) << text;
+    }
+
+    ~TemporaryCorpusFile() {
+        filesystem::remove(path_);
+    }
+
+    string GetPath() const {
+        return path_.string();
+    }
+
+private:
+    filesystem::path path_;
+};
+
+void TestSplitAtLineBoundaries() {
+    const string kText = "a\nbb\nccc\ndddd\neeeee\nf"s;
+    for (size_t part_count = 1U; part_count <= 8U; ++part_count) {
+        const auto kParts = SplitAtLineBoundaries(kText, part_count);
+        ASSERT(kParts.size() <= part_count);
+
+        string joined;
+        for (size_t i = 0U; i < kParts.size(); ++i) {
+            ASSERT(!kParts[i].empty());
+            ASSERT(i + 1U == kParts.size() || kParts[i].back() == '\n');
+            joined += kParts[i];
+        }
+        ASSERT_EQUAL(joined, kText);
+    }
+    ASSERT(SplitAtLineBoundaries(""s, 4U).empty());
+}
+
+void TestLoadMappedCorpus() {
+    string corpus;
+    for (int id = 1; id <= 100; ++id) {
+        corpus += to_string(id) + "\t0\t"s + to_string(id) + "\tword"s + to_string(id % 7) + " common\n"s;
+    }
+    corpus += "\n101\t2\t\tbanned word\r\n"s;
+    const TemporaryCorpusFile kFile(corpus);
+
+    SearchServer mapped_server("word3"s);
+    const auto kStats = LoadMappedCorpus(mapped_server, kFile.GetPath(), 4U);
+    ASSERT_EQUAL(kStats.documents, 101U);
+    ASSERT_EQUAL(kStats.bytes, corpus.size());
+
+    // a single thread still splits the file into several parts and keeps one of them in flight at a time
+    SearchServer sequential_server("word3"s);
+    ASSERT_EQUAL(LoadMappedCorpus(sequential_server, kFile.GetPath(), 1U).documents, 101U);
+    ASSERT_EQUAL(sequential_server.GetDocumentCount(), mapped_server.GetDocumentCount());
+
+    SearchServer streamed_server("word3"s);
+    IngestionOptions options;
+    options.progress_output = nullptr;
+    istringstream input(corpus);
+    IngestCorpus(streamed_server, input, options);
+
+    ASSERT_EQUAL(mapped_server.GetDocumentCount(), streamed_server.GetDocumentCount());
+    for (const int kId: streamed_server) {
+        const auto kExpected = streamed_server.GetWordFrequencies(kId);
+        const auto kActual = mapped_server.GetWordFrequencies(kId);
+        ASSERT(equal(kActual.begin(), kActual.end(), kExpected.begin(), kExpected.end()));
+    }
+    ASSERT_EQUAL(mapped_server.FindTopDocuments("word3"s).size(), 0U);
+    ASSERT_EQUAL(mapped_server.FindTopDocuments("banned"s, DocumentStatus::BANNED).size(), 1U);
+}
+
+void TestLoadMappedCorpusErrors() {
+    string corpus;
+    for (int id = 1; id <= 100; ++id) {
+        corpus += id == 57 ? "bad line\n"s : to_string(id) + "\t0\t\tcat\n"s;
+    }
+    const TemporaryCorpusFile kFile(corpus);
+
+    SearchServer server;
+    try {
+        LoadMappedCorpus(server, kFile.GetPath(), 4U);
+        ASSERT_HINT(false, "a malformed line must throw"s);
+    } catch (const invalid_argument &error) {
+        ASSERT_EQUAL(string(error.what()).find("corpus line 57:"s), 0U);
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 56U);
+
+    const TemporaryCorpusFile kEmptyFile(""s);
+    ASSERT_EQUAL(LoadMappedCorpus(server, kEmptyFile.GetPath()).documents, 0U);
+    CheckThrow<runtime_error>([&server]() { LoadMappedCorpus(server, "/nonexistent/corpus.tsv"s); });
+}
+
+void TestMappedCorpus() {
+    RUN_TEST(TestSplitAtLineBoundaries);
+    RUN_TEST(TestLoadMappedCorpus);
+    RUN_TEST(TestLoadMappedCorpusErrors);
+    std::cerr << std::endl;
+}
@@ -3,6 +3,8 @@
 #include "test_framework.h"
 #include "paginator.h"
 
+#include <forward_list>
+#include <list>
 #include <numeric>
 #include <sstream>
 
@@ -87,11 +89,41 @@ void TestPagePagination() {
     ASSERT(lines == expected);
 }
 
+void TestRandomAccessPages() {
+    vector<int> v(10'000'000);
+    iota(begin(v), end(v), 0);
+
+    const auto kPages = Paginate(v, 3);
+    ASSERT_EQUAL(kPages.size(), 3'333'334U);
+    ASSERT_EQUAL(*kPages[1'000'000].begin(), 3'000'000);
+    ASSERT_EQUAL(kPages[1'000'000].size(), 3U);
+    ASSERT_EQUAL(kPages[kPages.size() - 1U].size(), 1U);
+    ASSERT_EQUAL(*kPages[kPages.size() - 1U].begin(), 9'999'999);
+
+    CheckThrow<invalid_argument>([&v]() { Paginate(v, 0); });
+}
+
+void TestStreamingPages() {
+    const list<int> kValues = {1, 2, 3, 4, 5, 6, 7};
+    vector<vector<int>> pages;
+    for (const auto &page: Paginate(kValues, 3)) {
+        pages.emplace_back(page.begin(), page.end());
+    }
+    const vector<vector<int>> kExpected = {{1, 2, 3}, {4, 5, 6}, {7}};
+    ASSERT(pages == kExpected);
+
+    const forward_list<int> kEmpty;
+    const auto kEmptyPages = Paginate(kEmpty, 3);
+    ASSERT(kEmptyPages.begin() == kEmptyPages.end());
+}
+
 void TestPaginator() {
     RUN_TEST(TestPageCounts);
     RUN_TEST(TestLooping);
     RUN_TEST(TestPageSizes);
     RUN_TEST(TestConstContainer);
     RUN_TEST(TestPagePagination);
+    RUN_TEST(TestRandomAccessPages);
+    RUN_TEST(TestStreamingPages);
     std::cerr << std::endl;
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "test_framework.h"
+#include "profiler.h"
+#include "search_server.h"
+
+#include <sstream>
+#include <thread>
+
+
+using namespace std;
+
+// Enables the profiler from a clean state and restores it afterwards
+class ProfilerSession {
+public:
+    ProfilerSession() : was_enabled_(Profiler::GetInstance().IsEnabled()) {
+        Profiler::GetInstance().Reset();
+        Profiler::GetInstance().SetEnabled(true);
+    }
+
+    ~ProfilerSession() {
+        Profiler::GetInstance().SetEnabled(was_enabled_);
+        Profiler::GetInstance().Reset();
+    }
+
+private:
+    const bool was_enabled_;
+};
+
+void ProfiledWork(int iterations) {
+    for (int i = 0; i < iterations; ++i) {
+        PROFILE_SCOPE("test/work");
+        this_thread::sleep_for(chrono::microseconds(10));
+    }
+}
+
+void TestProfilerAggregates() {
+    ProfilerSession session;
+    ProfiledWork(3);
+
+    const ProfileSnapshot kSnapshot = Profiler::GetInstance().GetSnapshot();
+    ASSERT_EQUAL(kSnapshot.count("test/work"s), 1U);
+    const ProfileStats &kStats = kSnapshot.at("test/work"s);
+    ASSERT_EQUAL(kStats.count, 3U);
+    ASSERT_EQUAL(kStats.histogram.GetCount(), 3U);
+    ASSERT(kStats.min_ns >= 10000U);
+    ASSERT(kStats.min_ns <= kStats.max_ns);
+    ASSERT(kStats.total_ns >= 3U * kStats.min_ns && kStats.total_ns <= 3U * kStats.max_ns);
+
+    Profiler::GetInstance().Reset();
+    ASSERT(Profiler::GetInstance().GetSnapshot().empty());
+}
+
+void TestProfilerMergesThreads() {
+    ProfilerSession session;
+    // one thread is still running when the snapshot is taken, the others have exited
+    {
+        vector<thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back(ProfiledWork, 5);
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+    ProfiledWork(2);
+
+    ASSERT_EQUAL(Profiler::GetInstance().GetSnapshot().at("test/work"s).count, 22U);
+}
+
+void TestProfilerDisabled() {
+    ProfilerSession session;
+    Profiler::GetInstance().SetEnabled(false);
+    ProfiledWork(3);
+    ASSERT(Profiler::GetInstance().GetSnapshot().empty());
+}
+
+void TestProfilerSearchServerScopes() {
+    ProfilerSession session;
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, {2});
+    server.FindTopDocuments("cat"s);
+    server.MatchDocument("cat"s, 1);
+    server.RemoveDocument(2);
+
+    const ProfileSnapshot kSnapshot = Profiler::GetInstance().GetSnapshot();
+    ASSERT_EQUAL(kSnapshot.at("SearchServer::AddDocument"s).count, 2U);
+    ASSERT_EQUAL(kSnapshot.at("SearchServer::FindTopDocuments"s).count, 1U);
+    ASSERT_EQUAL(kSnapshot.at("SearchServer::MatchDocument"s).count, 1U);
+    ASSERT_EQUAL(kSnapshot.at("SearchServer::RemoveDocument"s).count, 1U);
+
+    ostringstream output;
+    Profiler::PrintSnapshot(kSnapshot, output);
+    ASSERT(output.str().find("SearchServer::AddDocument"s) != string::npos);
+}
+
+void TestProfiler() {
+    RUN_TEST(TestProfilerAggregates);
+    RUN_TEST(TestProfilerMergesThreads);
+    RUN_TEST(TestProfilerDisabled);
+    RUN_TEST(TestProfilerSearchServerScopes);
+    std::cerr << std::endl;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "test_framework.h"
+#include "remove_duplicates.h"
+
+
+void TestRemoveDuplicatesKeepsLowestId() {
+    SearchServer search_server("and with"s);
+
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(7, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+
+    RemoveDuplicates(search_server);
+
+    ASSERT_EQUAL(std::vector<int>(search_server.begin(), search_server.end()), (std::vector<int>{1, 2, 6, 8, 9}));
+}
+
+void TestRemoveDuplicatesByExecutionPolicy() {
+    const auto kFillServer = [](SearchServer &server) {
+        for (int id = 0; id < 200; ++id) {
+            const int kGroup = (id * 7) % 31;
+            server.AddDocument(id, "word"s + std::to_string(kGroup) + " tail"s + std::to_string(kGroup % 5),
+                               DocumentStatus::ACTUAL, {});
+        }
+    };
+
+    SearchServer sequential;
+    kFillServer(sequential);
+    SearchServer parallel;
+    kFillServer(parallel);
+
+    const auto kSequentialBin = RemoveDuplicates(std::execution::seq, sequential);
+    const auto kParallelBin = RemoveDuplicates(std::execution::par, parallel);
+
+    ASSERT_EQUAL(kSequentialBin.size(), 200U - 31U);
+    ASSERT_EQUAL(kParallelBin, kSequentialBin);
+    ASSERT_EQUAL(std::vector<int>(parallel.begin(), parallel.end()),
+                 std::vector<int>(sequential.begin(), sequential.end()));
+    ASSERT_EQUAL(*parallel.begin(), 0);
+}
+
+void TestRemoveNearDuplicates() {
+    SearchServer search_server;
+
+    search_server.AddDocument(1, "red bike for sale cheap good condition price 100 call today"s,
+                              DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(2, "red bike for sale cheap good condition price 120 call today"s,
+                              DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(3, "blue car for rent weekly with insurance and free delivery"s,
+                              DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(4, "red bike for sale cheap good condition price 100 call today"s,
+                              DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(5, "red bike for sale"s, DocumentStatus::ACTUAL, {});
+
+    NearDuplicateOptions options;
+    options.jaccard_threshold = 0.8;
+    ASSERT_EQUAL(RemoveNearDuplicates(search_server, options), (std::vector<int>{2, 4}));
+
+    ASSERT_EQUAL(std::vector<int>(search_server.begin(), search_server.end()), (std::vector<int>{1, 3, 5}));
+}
+
+void TestRemoveNearDuplicatesLowThreshold() {
+    // every pair shares 6 of 14 distinct words, a similarity of 0.43
+    SearchServer search_server;
+    std::vector<int> expected_bin;
+    for (int pair = 0; pair < 50; ++pair) {
+        std::string first;
+        std::string second;
+        for (int word = 0; word < 10; ++word) {
+            const std::string kPrefix = " p"s + std::to_string(pair) + "w"s;
+            first += kPrefix + std::to_string(word);
+            second += kPrefix + std::to_string(word < 6 ? word : word + 10);
+        }
+        search_server.AddDocument(2 * pair, first, DocumentStatus::ACTUAL, {});
+        search_server.AddDocument(2 * pair + 1, second, DocumentStatus::ACTUAL, {});
+        expected_bin.push_back(2 * pair + 1);
+    }
+
+    NearDuplicateOptions options;
+    options.jaccard_threshold = 0.5;
+    ASSERT_HINT(RemoveNearDuplicates(search_server, options).empty(), "pairs below the threshold are kept");
+    options.jaccard_threshold = 0.3;
+    ASSERT_HINT(RemoveNearDuplicates(search_server, options) == expected_bin, "bands follow the threshold");
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 50U);
+}
+
+void TestNearDuplicateOptionsValidation() {
+    SearchServer search_server;
+    for (const double kThreshold: {0.0, -0.5, 1.5}) {
+        NearDuplicateOptions options;
+        options.jaccard_threshold = kThreshold;
+        CheckThrow<std::invalid_argument>([&search_server, &options]() {
+            RemoveNearDuplicates(search_server, options);
+        });
+    }
+    NearDuplicateOptions options;
+    options.signature_size = 0U;
+    CheckThrow<std::invalid_argument>([&search_server, &options]() { RemoveNearDuplicates(search_server, options); });
+}
+
+void TestRemoveDuplicates() {
+    RUN_TEST(TestRemoveDuplicatesKeepsLowestId);
+    RUN_TEST(TestRemoveDuplicatesByExecutionPolicy);
+    RUN_TEST(TestRemoveNearDuplicates);
+    RUN_TEST(TestRemoveNearDuplicatesLowThreshold);
+    RUN_TEST(TestNearDuplicateOptionsValidation);
+    std::cerr << std::endl;
+}
@@ -2,6 +2,9 @@
 
 #include "test_framework.h"
 #include "request_queue.h"
+#include "concurrent_request_queue.h"
+
+#include <thread>
 
 
 void TestRequestQueueGetNoResultRequests() {
@@ -25,7 +28,176 @@ void TestRequestQueueGetNoResultRequests() {
     ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1437);
 }
 
+inline RequestQueue::Clock::time_point fake_now{};
+
+RequestQueue::Clock::time_point FakeNow() {
+    return fake_now;
+}
+
+void TestRequestQueueWallClockWindow() {
+    using namespace std::chrono_literals;
+
+    SearchServer search_server;
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {});
+
+    fake_now = RequestQueue::Clock::time_point{};
+    RequestQueue request_queue(search_server, 24h, 1min, &FakeNow);
+
+    request_queue.AddFindRequest("dog"s);
+    request_queue.AddFindRequest("cat"s);
+    fake_now += 1h;
+    request_queue.AddFindRequest("dog"s);
+    request_queue.AddFindRequest("bird"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 3);
+
+    fake_now += 23h;
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 2);
+
+    fake_now += 30min;
+    request_queue.AddFindRequest("cat"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 2);
+
+    fake_now += 1h;
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 0);
+
+    fake_now += 1000h;
+    request_queue.AddFindRequest("dog"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1);
+}
+
+void TestRequestQueueWindowValidation() {
+    using namespace std::chrono_literals;
+
+    SearchServer search_server;
+    CheckThrow<invalid_argument>([&search_server]() { RequestQueue(search_server, 1h, 0s, &FakeNow); });
+    CheckThrow<invalid_argument>([&search_server]() { RequestQueue(search_server, 1h, -1s, &FakeNow); });
+    CheckThrow<invalid_argument>([&search_server]() { RequestQueue(search_server, 0h, 1s, &FakeNow); });
+    CheckThrow<invalid_argument>([&search_server]() { ConcurrentRequestQueue(search_server, 1h, 0s, 2U, &FakeNow); });
+    CheckThrow<invalid_argument>([&search_server]() { ConcurrentRequestQueue(search_server, -1h, 1s, 2U, &FakeNow); });
+
+    ASSERT_EQUAL(RequestQueue::GetBucketCount(1h, 1min), 60U);
+    ASSERT_EQUAL(RequestQueue::GetBucketCount(61s, 1min), 2U);
+    ASSERT_EQUAL(RequestQueue::GetBucketCount(1s, 1min), 1U);
+}
+
+void TestRequestQueueHistograms() {
+    SearchServer search_server;
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(2, "fancy cat"s, DocumentStatus::ACTUAL, {});
+
+    RequestQueue request_queue(search_server, 32);
+    for (int i = 0; i < 32; ++i) {
+        request_queue.AddFindRequest("cat"s);
+    }
+    ASSERT_EQUAL(request_queue.GetLatencyHistogram().GetCount(), 32U);
+    ASSERT_EQUAL(request_queue.GetResultCountHistogram().GetP50(), 2U);
+
+    for (int i = 0; i < 32; ++i) {
+        request_queue.AddFindRequest("dog"s);
+    }
+    ASSERT_EQUAL(request_queue.GetResultCountHistogram().GetCount(), 32U);
+    ASSERT_EQUAL(request_queue.GetResultCountHistogram().GetP99(), 0U);
+}
+
+void TestRequestQueueResultCache() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(2, "fancy dog"s, DocumentStatus::ACTUAL, {});
+
+    RequestQueue request_queue(search_server);
+    request_queue.EnableResultCache(2U, 1U << 20U);
+    const QueryCache &kCache = *request_queue.GetResultCache();
+
+    const auto kFirst = request_queue.AddFindRequest("cat and dog -bird"s);
+    const auto kSecond = request_queue.AddFindRequest("dog -bird cat cat"s);
+    ASSERT_EQUAL(kCache.GetMissCount(), 1U);
+    ASSERT_EQUAL(kCache.GetHitCount(), 1U);
+    ASSERT_EQUAL(kSecond.size(), kFirst.size());
+
+    request_queue.AddFindRequest("cat and dog -bird"s, DocumentStatus::BANNED);
+    ASSERT_EQUAL(kCache.GetMissCount(), 2U);
+
+    search_server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, {});
+    ASSERT_EQUAL(request_queue.AddFindRequest("cat dog -bird"s).size(), 3U);
+    ASSERT_EQUAL(kCache.GetMissCount(), 3U);
+    ASSERT_EQUAL(kCache.GetEntryCount(), 1U);
+
+    request_queue.AddFindRequest("cat"s);
+    request_queue.AddFindRequest("dog"s);
+    ASSERT_EQUAL(kCache.GetEntryCount(), 2U);
+    ASSERT(kCache.GetMemoryUsage() > 0U);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1);
+}
+
+// Compaction erases postings of tombstoned documents only, so it must not change the generation the cache keys on
+void TestRequestQueueResultCacheAcrossCompaction() {
+    SearchServer search_server;
+    search_server.SetRemovalPolicy(SearchServer::RemovalPolicy::DEFERRED);
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(2, "fancy cat with collar"s, DocumentStatus::ACTUAL, {});
+    search_server.AddDocument(3, "fancy dog"s, DocumentStatus::ACTUAL, {});
+    search_server.RemoveDocument(2);
+
+    RequestQueue request_queue(search_server);
+    request_queue.EnableResultCache(4U, 1U << 20U);
+    const QueryCache &kCache = *request_queue.GetResultCache();
+
+    const auto kBefore = request_queue.AddFindRequest("cat fancy"s);
+    ASSERT_EQUAL(kCache.GetMissCount(), 1U);
+
+    ASSERT_EQUAL(search_server.CompactRemovedDocuments(2U), 2U);
+    request_queue.AddFindRequest("cat fancy"s);
+    ASSERT_EQUAL(search_server.CompactRemovedDocuments(), 2U);
+    const auto kAfter = request_queue.AddFindRequest("cat fancy"s);
+    ASSERT_EQUAL(kCache.GetMissCount(), 1U);
+    ASSERT_EQUAL(kCache.GetHitCount(), 2U);
+    ASSERT_EQUAL(kAfter.size(), kBefore.size());
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat fancy"s).size(), kBefore.size());
+
+    // a removal does change results
+    search_server.RemoveDocument(3);
+    ASSERT_EQUAL(request_queue.AddFindRequest("cat fancy"s).size(), 1U);
+    ASSERT_EQUAL(kCache.GetMissCount(), 2U);
+}
+
+void TestConcurrentRequestQueue() {
+    using namespace std::chrono_literals;
+
+    SearchServer search_server;
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {});
+
+    fake_now = RequestQueue::Clock::time_point{};
+    ConcurrentRequestQueue request_queue(search_server, 1h, 1s, 3U, &FakeNow);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&request_queue]() {
+            for (int j = 0; j < 250; ++j) {
+                request_queue.AddFindRequest("dog"s);
+                request_queue.AddFindRequest("cat"s);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1000);
+
+    fake_now += 30min;
+    request_queue.AddFindRequest("bird"s);
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1001);
+
+    fake_now += 30min;
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1);
+}
+
 void TestRequestQueue() {
     RUN_TEST(TestRequestQueueGetNoResultRequests);
+    RUN_TEST(TestRequestQueueWallClockWindow);
+    RUN_TEST(TestRequestQueueWindowValidation);
+    RUN_TEST(TestRequestQueueHistograms);
+    RUN_TEST(TestRequestQueueResultCache);
+    RUN_TEST(TestRequestQueueResultCacheAcrossCompaction);
+    RUN_TEST(TestConcurrentRequestQueue);
     std::cerr << std::endl;
 }
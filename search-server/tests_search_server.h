@@ -3,6 +3,7 @@
 #include "search_server.h"
 #include "test_framework.h"
 
+#include <atomic>
 #include <cmath>
 
 using namespace std;
@@ -112,6 +113,46 @@ void TestDocumentMatchedByMinusWords() {
     ASSERT(kWords.empty());
 }
 
+void TestDocumentMatchedByExecutionPolicy() {
+    SearchServer server("and with"s);
+    const int kId = 42;
+    server.AddDocument(kId, string{"funny pet and nasty rat with curly hair"}, DocumentStatus::BANNED, {});
+
+    const vector<string> kQueries = {"pet rat rat dog"s, "curly and hair -dog"s, "funny -nasty"s, "cat"s};
+    for (const string &query: kQueries) {
+        const auto[kWords, kStatus] = server.MatchDocument(query, kId);
+        const auto[kSeqWords, kSeqStatus] = server.MatchDocument(execution::seq, query, kId);
+        const auto[kParWords, kParStatus] = server.MatchDocument(execution::par, query, kId);
+
+        ASSERT_EQUAL_HINT(kSeqWords, kWords, query);
+        ASSERT_EQUAL_HINT(kParWords, kWords, query);
+        ASSERT_EQUAL(kSeqStatus, DocumentStatus::BANNED);
+        ASSERT_EQUAL(kParStatus, DocumentStatus::BANNED);
+    }
+
+    const auto[kWords, _] = server.MatchDocument(execution::par, "rat pet rat"s, kId);
+    ASSERT_EQUAL(kWords, (vector<string>{"pet"s, "rat"s}));
+}
+
+void TestDocumentMatchedAsView() {
+    SearchServer server;
+    const int kId = 42;
+    server.AddDocument(kId, string{"huge flying green cat"}, DocumentStatus::ACTUAL, {});
+
+    string query = "cat green dog"s;
+    const auto[kWords, kStatus] = server.MatchDocumentView(query, kId);
+    query.assign(query.size(), 'x');
+
+    ASSERT_EQUAL(kStatus, DocumentStatus::ACTUAL);
+    ASSERT_EQUAL(kWords, (vector<string_view>{"cat"sv, "green"sv}));
+
+    vector<string_view> buffer{"stale"sv};
+    ASSERT_EQUAL(server.MatchDocument("huge -cat"s, kId, buffer), DocumentStatus::ACTUAL);
+    ASSERT(buffer.empty());
+    server.MatchDocument("flying"s, kId, buffer);
+    ASSERT_EQUAL(buffer, vector<string_view>{"flying"sv});
+}
+
 // Сортировка найденных документов по релевантности. Возвращаемые при поиске документов результаты
 // должны быть отсортированы в порядке убывания релевантности.
 
@@ -274,16 +315,558 @@ void TestGetWordFrequencies() {
             {"delta",   0.25}
     };
     const auto result = server.GetWordFrequencies(2);
-    for (auto&[word, frequency]: result) {
-        ASSERT(IsDoubleEqual(expected[word], frequency));
+    ASSERT_EQUAL(result.size(), expected.size());
+    for (const auto &[word, frequency]: result) {
+        ASSERT(IsDoubleEqual(expected[string(word)], frequency));
     }
 }
 
+void TestGetWordFrequenciesAfterRemovals() {
+    SearchServer server;
+    for (int id = 0; id < 10; ++id) {
+        server.AddDocument(id, "common word"s + to_string(id) + " tail"s + to_string(id % 3), DocumentStatus::ACTUAL, {});
+    }
+    for (int id = 0; id < 8; ++id) {
+        server.RemoveDocument(id);
+    }
+
+    const auto kWords = server.GetWordFrequencies(9);
+    vector<string> words;
+    for (const auto &[word, _]: kWords) {
+        words.emplace_back(word);
+    }
+    ASSERT_EQUAL(words, (vector<string>{"common"s, "tail0"s, "word9"s}));
+    ASSERT_EQUAL(kWords.count("word9"sv), 1U);
+    ASSERT_EQUAL(kWords.count("word8"sv), 0U);
+    ASSERT(IsDoubleEqual(kWords.find("common"sv)->second, 1.0 / 3.0));
+    ASSERT_EQUAL(server.FindTopDocuments("common"s).size(), 2U);
+}
+
 void TestGetWordFrequenciesWrongId() {
     SearchServer server;
     ASSERT(server.GetWordFrequencies(2).empty());
 }
 
+void TestDeferredRemoval() {
+    SearchServer server;
+    server.SetRemovalPolicy(SearchServer::RemovalPolicy::DEFERRED);
+    server.AddDocument(1, "alpha bravo"s, DocumentStatus::ACTUAL, {});
+    server.AddDocument(2, "alpha charley delta"s, DocumentStatus::ACTUAL, {});
+    server.AddDocument(3, "bravo"s, DocumentStatus::ACTUAL, {});
+
+    server.RemoveDocument(2);
+
+    ASSERT_EQUAL(server.GetDocumentCount(), 2U);
+    ASSERT_EQUAL(server.GetRemovedDocumentCount(), 1U);
+    ASSERT(server.GetWordFrequencies(2).empty());
+    ASSERT(server.FindTopDocuments("charley"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("alpha"s).size(), 1U);
+    ASSERT_EQUAL(vector<int>(server.begin(), server.end()), (vector<int>{1, 3}));
+    CheckThrow<out_of_range>([&server]() { server.MatchDocument("alpha"s, 2); });
+
+    const uint64_t kGeneration = server.GetIndexGeneration();
+    ASSERT_EQUAL(server.CompactRemovedDocuments(2U), 2U);
+    ASSERT_EQUAL(server.GetRemovedDocumentCount(), 1U);
+    ASSERT_EQUAL(server.CompactRemovedDocuments(), 1U);
+    ASSERT_EQUAL(server.GetRemovedDocumentCount(), 0U);
+    ASSERT_EQUAL(server.CompactRemovedDocuments(), 0U);
+    ASSERT_EQUAL(server.GetIndexGeneration(), kGeneration);
+
+    server.RemoveDocument(3);
+    server.AddDocument(3, "charley"s, DocumentStatus::ACTUAL, {});
+    ASSERT_EQUAL(server.GetRemovedDocumentCount(), 0U);
+    ASSERT_EQUAL(server.FindTopDocuments("bravo"s).front().id, 1);
+    ASSERT_EQUAL(server.FindTopDocuments("charley"s).front().id, 3);
+}
+
+void TestRemovalPoliciesRankEqually() {
+    const auto kRank = [](SearchServer::RemovalPolicy policy, size_t compaction_budget) {
+        SearchServer server;
+        server.SetRemovalPolicy(policy);
+        server.AddDocument(1, "x y"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(2, "x z"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(3, "w x"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(4, "w"s, DocumentStatus::ACTUAL, {});
+        server.RemoveDocument(3);
+        server.RemoveDocuments(vector<int>{4});
+        server.CompactRemovedDocuments(compaction_budget);
+
+        vector<double> relevances;
+        for (const string &query: {"y"s, "x y z"s, "w"s}) {
+            for (const Document &document: server.FindTopDocuments(query)) {
+                relevances.push_back(document.relevance);
+            }
+        }
+        return relevances;
+    };
+
+    const auto kImmediate = kRank(SearchServer::RemovalPolicy::IMMEDIATE, 0U);
+    ASSERT_EQUAL(kImmediate.size(), 3U);
+    ASSERT(IsDoubleEqual(kImmediate[0], 0.5 * log(2.0)));
+    for (const size_t kBudget: {size_t{0}, size_t{1}, size_t{2}, numeric_limits<size_t>::max()}) {
+        const auto kDeferred = kRank(SearchServer::RemovalPolicy::DEFERRED, kBudget);
+        ASSERT_EQUAL(kDeferred.size(), kImmediate.size());
+        for (size_t i = 0U; i < kImmediate.size(); ++i) {
+            ASSERT_HINT(IsDoubleEqual(kDeferred[i], kImmediate[i]), "tombstones do not change relevance");
+        }
+    }
+}
+
+void TestRemoveDocuments() {
+    const auto kFillServer = [](SearchServer &server) {
+        server.AddDocument(1, "alpha bravo"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(2, "alpha charley delta"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(3, "bravo charley"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(4, "delta echo"s, DocumentStatus::ACTUAL, {});
+    };
+    const vector<int> kRemovedIds = {4, 2, 42, 2};
+
+    SearchServer expected;
+    kFillServer(expected);
+    expected.RemoveDocument(2);
+    expected.RemoveDocument(4);
+
+    SearchServer sequential;
+    kFillServer(sequential);
+    sequential.RemoveDocuments(kRemovedIds);
+
+    SearchServer parallel;
+    kFillServer(parallel);
+    parallel.RemoveDocuments(execution::par, kRemovedIds);
+
+    for (const SearchServer *server: {&sequential, &parallel}) {
+        ASSERT_EQUAL(server->GetDocumentCount(), 2U);
+        ASSERT_EQUAL(vector<int>(server->begin(), server->end()), (vector<int>{1, 3}));
+        ASSERT(server->GetWordFrequencies(2).empty());
+        ASSERT(server->FindTopDocuments("delta echo"s).empty());
+        for (const string &query: {"alpha"s, "bravo"s, "charley"s}) {
+            const auto kExpected = expected.FindTopDocuments(query);
+            const auto kActual = server->FindTopDocuments(query);
+            ASSERT_EQUAL(kActual.size(), kExpected.size());
+            ASSERT_EQUAL(kActual.front().id, kExpected.front().id);
+            ASSERT(IsDoubleEqual(kActual.front().relevance, kExpected.front().relevance));
+        }
+    }
+}
+
+void TestDuplicatePolicy() {
+    {
+        SearchServer server("and"s);
+        server.SetDuplicatePolicy(SearchServer::DuplicatePolicy::REJECT);
+        ASSERT_EQUAL(server.AddDocument(1, "funny pet and rat"s, DocumentStatus::ACTUAL, {}), 1);
+        ASSERT_EQUAL(server.AddDocument(2, "rat rat funny pet"s, DocumentStatus::ACTUAL, {}), 1);
+        ASSERT_EQUAL(server.AddDocument(3, "funny pet"s, DocumentStatus::ACTUAL, {}), 3);
+        ASSERT_EQUAL(vector<int>(server.begin(), server.end()), (vector<int>{1, 3}));
+
+        server.RemoveDocument(1);
+        ASSERT_EQUAL(server.AddDocument(2, "rat funny pet"s, DocumentStatus::ACTUAL, {}), 2);
+    }
+    {
+        SearchServer server;
+        server.AddDocument(1, "funny pet rat"s, DocumentStatus::ACTUAL, {});
+        server.SetDuplicatePolicy(SearchServer::DuplicatePolicy::REPLACE);
+        ASSERT_EQUAL(server.AddDocument(2, "rat funny pet"s, DocumentStatus::BANNED, {}), 2);
+        ASSERT_EQUAL(vector<int>(server.begin(), server.end()), vector<int>{2});
+        ASSERT_EQUAL(server.FindTopDocuments("rat"s, DocumentStatus::BANNED).front().id, 2);
+    }
+    {
+        SearchServer server;
+        server.SetDuplicatePolicy(SearchServer::DuplicatePolicy::LINK);
+        server.AddDocument(1, "funny pet rat"s, DocumentStatus::ACTUAL, {});
+        ASSERT_EQUAL(server.AddDocument(2, "rat funny pet"s, DocumentStatus::ACTUAL, {}), 1);
+        ASSERT_EQUAL(server.GetCanonicalDocumentId(2), 1);
+        ASSERT_EQUAL(server.GetCanonicalDocumentId(1), 1);
+        ASSERT_EQUAL(server.GetDocumentCount(), 1U);
+        CheckThrow<invalid_argument>([&server]() { server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {}); });
+
+        server.RemoveDocument(1);
+        ASSERT_EQUAL(server.GetCanonicalDocumentId(2), 2);
+    }
+    {
+        // a batch removes linked duplicates the way RemoveDocument does
+        SearchServer server;
+        server.SetDuplicatePolicy(SearchServer::DuplicatePolicy::LINK);
+        server.AddDocument(1, "funny pet rat"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(2, "rat funny pet"s, DocumentStatus::ACTUAL, {});
+        server.AddDocument(3, "pet rat funny"s, DocumentStatus::ACTUAL, {});
+        const uint64_t kGeneration = server.GetIndexGeneration();
+
+        server.RemoveDocuments(vector<int>{2});
+        ASSERT_EQUAL(server.GetCanonicalDocumentId(2), 2);
+        ASSERT_EQUAL(server.GetCanonicalDocumentId(3), 1);
+        ASSERT_EQUAL(server.GetIndexGeneration(), kGeneration);
+        ASSERT_EQUAL(server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {}), 2);
+
+        server.RemoveDocuments(std::execution::par, vector<int>{3, 1});
+        ASSERT_EQUAL(server.GetCanonicalDocumentId(3), 3);
+        ASSERT_EQUAL(vector<int>(server.begin(), server.end()), vector<int>{2});
+    }
+}
+
+void TestFindTopDocumentsPage() {
+    SearchServer server;
+    for (int id = 1; id <= 12; ++id) {
+        // equal relevance and pairs of equal ratings, so pages must fall back to ids to stay disjoint
+        server.AddDocument(id, "cat"s, DocumentStatus::ACTUAL, {id / 2});
+    }
+    server.AddDocument(13, "dog"s, DocumentStatus::ACTUAL, {});
+    server.AddDocument(14, "cat"s, DocumentStatus::BANNED, {100});
+
+    vector<int> ids;
+    string token;
+    size_t pages = 0U;
+    do {
+        const auto kPage = server.FindTopDocumentsPage("cat"s, 5U, token);
+        ASSERT(kPage.documents.size() <= 5U);
+        for (const Document &document: kPage.documents) {
+            ids.push_back(document.id);
+        }
+        token = kPage.continuation_token;
+        ++pages;
+    } while (!token.empty());
+
+    const vector<int> kExpected = {12, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 1};
+    ASSERT_EQUAL(ids, kExpected);
+    ASSERT_EQUAL(pages, 3U);
+
+    const auto kFirstPage = server.FindTopDocumentsPage("cat"s, 5U);
+    const auto kTop = server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(kFirstPage.documents.size(), kTop.size());
+    for (size_t i = 0U; i < kTop.size(); ++i) {
+        ASSERT_EQUAL(kFirstPage.documents[i].rating, kTop[i].rating);
+    }
+
+    const auto kBanned = server.FindTopDocumentsPage("cat"s, DocumentStatus::BANNED, 5U);
+    ASSERT_EQUAL(kBanned.documents.size(), 1U);
+    ASSERT(kBanned.continuation_token.empty());
+
+    CheckThrow<invalid_argument>([&server]() { server.FindTopDocumentsPage("cat"s, 0U); });
+    CheckThrow<invalid_argument>([&server]() { server.FindTopDocumentsPage("cat"s, 5U, "garbage"s); });
+}
+
+void TestAllocationPolicy() {
+    const auto kFill = [](SearchServer &server) {
+        for (int id = 1; id <= 40; ++id) {
+            server.AddDocument(id, "cat"s + to_string(id % 5) + " dog"s + to_string(id % 3) + " common"s,
+                               DocumentStatus::ACTUAL, {id});
+        }
+    };
+    SearchServer heap_server;
+    kFill(heap_server);
+    SearchServer arena_server;
+    arena_server.SetAllocationPolicy(SearchServer::AllocationPolicy::ARENA);
+    kFill(arena_server);
+
+    const auto kSameResults = [&heap_server, &arena_server](const string &query) {
+        const auto kExpected = heap_server.FindTopDocuments(query);
+        const auto kActual = arena_server.FindTopDocuments(query);
+        ASSERT_EQUAL(kActual.size(), kExpected.size());
+        for (size_t i = 0U; i < kExpected.size(); ++i) {
+            ASSERT_EQUAL(kActual[i].id, kExpected[i].id);
+            ASSERT(IsDoubleEqual(kActual[i].relevance, kExpected[i].relevance));
+        }
+    };
+
+    // removing most documents compacts the forward index, which moves the posting lists to a fresh arena
+    for (int id = 1; id <= 30; ++id) {
+        heap_server.RemoveDocument(id);
+        arena_server.RemoveDocument(id);
+    }
+    kSameResults("cat1 dog2 -cat4"s);
+    ASSERT_EQUAL(get<0>(arena_server.MatchDocument("cat1 common"s, 36)), vector<string>({"cat1"s, "common"s}));
+
+    arena_server.SetRemovalPolicy(SearchServer::RemovalPolicy::DEFERRED);
+    heap_server.RemoveDocument(31);
+    arena_server.RemoveDocument(31);
+    arena_server.SetAllocationPolicy(SearchServer::AllocationPolicy::HEAP);
+    arena_server.CompactRemovedDocuments();
+    arena_server.SetAllocationPolicy(SearchServer::AllocationPolicy::ARENA);
+    kSameResults("cat2 dog0 common"s);
+}
+
+void TestTermViewsSurviveCompaction() {
+    SearchServer server;
+    server.SetAllocationPolicy(SearchServer::AllocationPolicy::ARENA);
+    // one short word and one too long for the inline buffer of a string
+    server.AddDocument(1, "alpha extraordinarily-long-term"s, DocumentStatus::ACTUAL, {1});
+    for (int id = 2; id <= 9; ++id) {
+        server.AddDocument(id, "alpha filler"s + to_string(id), DocumentStatus::ACTUAL, {id});
+    }
+
+    const auto[kMatched, kStatus] = server.MatchDocumentView("alpha extraordinarily-long-term"s, 1);
+    vector<string_view> buffer;
+    server.MatchDocument("alpha extraordinarily-long-term"s, 1, buffer);
+    const vector<string_view> kExpected = {"alpha"sv, "extraordinarily-long-term"sv};
+    ASSERT_EQUAL(kMatched, kExpected);
+    ASSERT_EQUAL(buffer, kExpected);
+
+    // the removals compact the forward index and rebuild the arena, the policy switches rebuild it twice more
+    server.RemoveDocuments(vector<int>{2, 3, 4, 5, 6, 7, 8});
+    server.RemoveDocument(9);
+    ASSERT_EQUAL(server.GetDocumentCount(), 1U);
+    ASSERT_EQUAL(kMatched, kExpected);
+    ASSERT_EQUAL(buffer, kExpected);
+
+    server.SetAllocationPolicy(SearchServer::AllocationPolicy::HEAP);
+    server.SetAllocationPolicy(SearchServer::AllocationPolicy::ARENA);
+    ASSERT_EQUAL(kMatched, kExpected);
+    ASSERT_EQUAL(buffer, kExpected);
+    ASSERT_EQUAL(server.FindTopDocuments("extraordinarily-long-term"s).size(), 1U);
+}
+
+// Counts what the server allocates, passing the requests to the heap
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    size_t GetAllocatedBytes() const {
+        return allocated_bytes_;
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        allocated_bytes_ += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    size_t allocated_bytes_ = 0U;
+};
+
+void TestMemoryResource() {
+    CountingMemoryResource resource;
+    // any container left on the default resource would throw std::bad_alloc
+    std::pmr::memory_resource *const kDefaultResource = std::pmr::set_default_resource(
+            std::pmr::null_memory_resource());
+    try {
+        SearchServer server("and with"s, &resource);
+        ASSERT(server.GetMemoryResource() == &resource);
+        server.SetDuplicatePolicy(SearchServer::DuplicatePolicy::LINK);
+        for (int id = 1; id <= 500; ++id) {
+            server.AddDocument(id, "funny pet and curly "s + to_string(id % 250), DocumentStatus::ACTUAL, {id});
+        }
+        const size_t kIndexBytes = resource.GetAllocatedBytes();
+        ASSERT(kIndexBytes > 0U);
+
+        // the relevance of 250 documents outgrows the stack buffer of the query
+        ASSERT_EQUAL(server.FindTopDocuments("pet"s).size(), 5U);
+        ASSERT(resource.GetAllocatedBytes() > kIndexBytes);
+
+        server.SetAllocationPolicy(SearchServer::AllocationPolicy::ARENA);
+        server.RemoveDocument(1);
+        ASSERT_EQUAL(server.GetDocumentCount(), 249U);
+    } catch (...) {
+        std::pmr::set_default_resource(kDefaultResource);
+        throw;
+    }
+    std::pmr::set_default_resource(kDefaultResource);
+}
+
+void TestBudgetedCompactionDefersShrinking() {
+    CountingMemoryResource resource;
+    SearchServer server(""s, &resource);
+    server.SetAllocationPolicy(SearchServer::AllocationPolicy::ARENA);
+    server.SetRemovalPolicy(SearchServer::RemovalPolicy::DEFERRED);
+    for (int id = 1; id <= 100; ++id) {
+        server.AddDocument(id, "word"s + to_string(id) + " group"s + to_string(id % 10) + " common"s,
+                           DocumentStatus::ACTUAL, {id});
+    }
+    for (int id = 11; id <= 100; ++id) {
+        server.RemoveDocument(id);
+    }
+    const size_t kAllocatedBytes = resource.GetAllocatedBytes();
+
+    // erasing only frees, while shrinking would allocate and copy 30 live postings twice, more than a slice has left
+    size_t erased_postings = 0U;
+    while (server.GetRemovedDocumentCount() > 0U) {
+        const size_t kErased = server.CompactRemovedDocuments(10U);
+        ASSERT(kErased <= 10U);
+        erased_postings += kErased;
+    }
+    ASSERT_EQUAL(erased_postings, 270U);
+    ASSERT_EQUAL(resource.GetAllocatedBytes(), kAllocatedBytes);
+
+    ASSERT_EQUAL(server.CompactRemovedDocuments(), 0U);
+    ASSERT(resource.GetAllocatedBytes() > kAllocatedBytes);
+    ASSERT_EQUAL(server.FindTopDocuments("group3 common"s).front().id, 3);
+    ASSERT_EQUAL(server.GetMemoryStats().posting_count, 30U);
+}
+
+// Passes requests to the heap and records whether two threads ever called it at once
+class OverlapDetectingMemoryResource : public std::pmr::memory_resource {
+public:
+    bool HasOverlapped() const {
+        return overlapped_;
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        const ScopedCall kCall(*this);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+        const ScopedCall kCall(*this);
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+    class ScopedCall {
+    public:
+        explicit ScopedCall(OverlapDetectingMemoryResource &resource) : resource_(resource) {
+            if (resource_.active_calls_.fetch_add(1) > 0) {
+                resource_.overlapped_ = true;
+            }
+        }
+
+        ~ScopedCall() {
+            resource_.active_calls_.fetch_sub(1);
+        }
+
+    private:
+        OverlapDetectingMemoryResource &resource_;
+    };
+
+    std::atomic<int> active_calls_{0};
+    std::atomic<bool> overlapped_{false};
+};
+
+void TestParallelRemovalWithUserResource() {
+    OverlapDetectingMemoryResource resource;
+    SearchServer server(""s, &resource);
+    vector<int> ids;
+    for (int id = 1; id <= 4000; ++id) {
+        server.AddDocument(id, "word"s + to_string(id % 500) + " term"s + to_string(id % 300) + " common"s,
+                           DocumentStatus::ACTUAL, {id});
+        if (id % 4 != 0) {
+            ids.push_back(id);
+        }
+    }
+
+    server.RemoveDocuments(execution::par, ids);
+    ASSERT(!resource.HasOverlapped());
+    ASSERT_EQUAL(server.GetDocumentCount(), 1000U);
+    ASSERT_EQUAL(server.FindTopDocuments("common"s).size(), 5U);
+}
+
+void TestMemoryStats() {
+    SearchServer server("and with"s);
+    const auto kEmpty = server.GetMemoryStats();
+    ASSERT_EQUAL(kEmpty.term_count, 0U);
+    ASSERT_EQUAL(kEmpty.posting_count, 0U);
+    ASSERT(kEmpty.stop_words_bytes > 0U);
+
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "funny pet with a remarkably-long-word-that-leaves-the-inline-buffer"s,
+                       DocumentStatus::ACTUAL, {1});
+    const auto kStats = server.GetMemoryStats();
+    ASSERT_EQUAL(kStats.term_count, 6U);
+    ASSERT_EQUAL(kStats.posting_count, 8U);
+    ASSERT_EQUAL(kStats.document_count, 2U);
+    ASSERT(IsDoubleEqual(kStats.average_posting_length, 8.0 / 6.0));
+    ASSERT(kStats.term_dictionary_bytes > 0U);
+    ASSERT(kStats.postings_bytes > 0U);
+    ASSERT(kStats.forward_index_bytes >= 8U * sizeof(void *));
+    ASSERT(kStats.document_metadata_bytes > 0U);
+    ASSERT_EQUAL(kStats.GetTotalBytes(), kStats.term_dictionary_bytes + kStats.postings_bytes +
+                                         kStats.forward_index_bytes + kStats.document_metadata_bytes +
+                                         kStats.stop_words_bytes);
+
+    server.RemoveDocument(2);
+    const auto kAfterRemoval = server.GetMemoryStats();
+    ASSERT_EQUAL(kAfterRemoval.term_count, 4U);
+    ASSERT_EQUAL(kAfterRemoval.posting_count, 4U);
+    ASSERT(kAfterRemoval.term_dictionary_bytes < kStats.term_dictionary_bytes);
+    ASSERT(kAfterRemoval.document_metadata_bytes < kStats.document_metadata_bytes);
+}
+
+void TestQueryStats() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "funny cat"s, DocumentStatus::BANNED, {2});
+
+    SearchServer::QueryStats stats;
+    const auto kDocuments = server.FindTopDocuments("funny pet dog -hair"s, stats);
+    ASSERT_EQUAL(kDocuments.size(), 1U);
+    ASSERT_EQUAL(stats.terms_resolved, 3U);
+    ASSERT_EQUAL(stats.postings_scanned, 6U);
+    ASSERT_EQUAL(stats.predicate_evaluations, 5U);
+    ASSERT_EQUAL(stats.documents_scored, 2U);
+    ASSERT_EQUAL(stats.documents_excluded_by_minus_words, 1U);
+    ASSERT_EQUAL(stats.candidates_sorted, 1U);
+
+    ASSERT_EQUAL(kDocuments[0].id, 1);
+    ASSERT_EQUAL(server.FindTopDocuments("funny pet dog -hair"s)[0].id, 1);
+    server.FindTopDocuments("funny"s, DocumentStatus::BANNED, stats);
+    ASSERT_EQUAL(stats.predicate_evaluations, 8U);
+    ASSERT_EQUAL(stats.candidates_sorted, 2U);
+
+    SearchServer::QueryStats match_stats;
+    vector<string_view> matched_words;
+    server.MatchDocument("funny pet -hair"s, 2, matched_words, match_stats);
+    ASSERT(matched_words.empty());
+    ASSERT_EQUAL(match_stats.terms_resolved, 1U);
+    ASSERT_EQUAL(match_stats.documents_excluded_by_minus_words, 1U);
+    server.MatchDocument("funny pet -hair"s, 1, matched_words, match_stats);
+    ASSERT_EQUAL(matched_words.size(), 2U);
+    ASSERT_EQUAL(match_stats.terms_resolved, 4U);
+    ASSERT_EQUAL(match_stats.documents_excluded_by_minus_words, 1U);
+}
+
+void TestExplainQuery() {
+    SearchServer server("and with"s);
+    server.SetRemovalPolicy(SearchServer::RemovalPolicy::DEFERRED);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "funny cat"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(4, "nasty dog"s, DocumentStatus::ACTUAL, {3});
+    server.RemoveDocument(3);
+
+    const string kQuery = "funny and pet dog -hair -ghost"s;
+    const auto kExplanation = server.ExplainQuery(kQuery);
+    ASSERT(kExplanation.strategy == SearchServer::QueryStrategy::TERM_AT_A_TIME);
+
+    ASSERT_EQUAL(kExplanation.plus_terms.size(), 3U);
+    const auto &kFunny = kExplanation.plus_terms[1];
+    ASSERT_EQUAL(kFunny.word, "funny"s);
+    ASSERT(kFunny.is_indexed);
+    ASSERT_HINT(kFunny.document_frequency == 2U && kFunny.posting_list_length == 3U,
+                "the tombstoned document keeps its posting");
+    ASSERT_HINT(IsDoubleEqual(kFunny.inverse_document_frequency, log(3.0 / 2.0)), "tombstones do not count in the IDF");
+
+    ASSERT_EQUAL(kExplanation.minus_terms.size(), 2U);
+    ASSERT_EQUAL(kExplanation.minus_terms[0].word, "ghost"s);
+    ASSERT(!kExplanation.minus_terms[0].is_indexed);
+    ASSERT_EQUAL(kExplanation.minus_terms[0].posting_list_length, 0U);
+    ASSERT_EQUAL(kExplanation.minus_terms[1].document_frequency, 1U);
+
+    ASSERT_EQUAL(kExplanation.stats.terms_resolved, 4U);
+    ASSERT_EQUAL(kExplanation.stats.documents_excluded_by_minus_words, 1U);
+    ASSERT_EQUAL(kExplanation.stats.candidates_sorted, 2U);
+
+    const auto kDocuments = server.FindTopDocuments(kQuery);
+    ASSERT_EQUAL(kExplanation.documents.size(), kDocuments.size());
+    for (size_t i = 0U; i < kDocuments.size(); ++i) {
+        ASSERT_EQUAL(kExplanation.documents[i].id, kDocuments[i].id);
+        ASSERT(IsDoubleEqual(kExplanation.documents[i].relevance, kDocuments[i].relevance));
+    }
+
+    const auto kNoMatches = server.ExplainQuery("ghost -funny"s);
+    ASSERT(kNoMatches.strategy == SearchServer::QueryStrategy::NO_MATCHING_TERMS);
+    ASSERT_HINT(kNoMatches.stats.terms_resolved == 0U, "minus words are not looked up when nothing is scored");
+    ASSERT(kNoMatches.minus_terms[0].is_indexed);
+    ASSERT(kNoMatches.documents.empty());
+}
+
 void TestSearchServer() {
     RUN_TEST(TestSearchOnEmptyBase);
     RUN_TEST(TestFoundAddedDocument);
@@ -293,6 +876,8 @@ void TestSearchServer() {
     RUN_TEST(TestSearchResultsByMinusWords);
     RUN_TEST(TestDocumentMatchedByPlusWords);
     RUN_TEST(TestDocumentMatchedByMinusWords);
+    RUN_TEST(TestDocumentMatchedByExecutionPolicy);
+    RUN_TEST(TestDocumentMatchedAsView);
     RUN_TEST(TestDocumentsSortingByRelevance);
     RUN_TEST(TestRatingCalculation);
     RUN_TEST(TestFoundAddedDocumentByStatus);
@@ -305,5 +890,19 @@ void TestSearchServer() {
     RUN_TEST(TestIterateByConstServer);
     RUN_TEST(TestGetWordFrequenciesWrongId);
     RUN_TEST(TestGetWordFrequencies);
+    RUN_TEST(TestGetWordFrequenciesAfterRemovals);
+    RUN_TEST(TestDeferredRemoval);
+    RUN_TEST(TestRemovalPoliciesRankEqually);
+    RUN_TEST(TestRemoveDocuments);
+    RUN_TEST(TestDuplicatePolicy);
+    RUN_TEST(TestFindTopDocumentsPage);
+    RUN_TEST(TestAllocationPolicy);
+    RUN_TEST(TestTermViewsSurviveCompaction);
+    RUN_TEST(TestMemoryResource);
+    RUN_TEST(TestBudgetedCompactionDefersShrinking);
+    RUN_TEST(TestParallelRemovalWithUserResource);
+    RUN_TEST(TestMemoryStats);
+    RUN_TEST(TestQueryStats);
+    RUN_TEST(TestExplainQuery);
     std::cerr << std::endl;
 }
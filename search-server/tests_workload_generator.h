@@ -0,0 +1,227 @@
+#pragma once
+
+#include "test_framework.h"
+#include "search_server.h"
+#include "workload_generator.h"
+
+#include <limits>
+#include <map>
+#include <set>
+
+
+using namespace std;
+
+void TestWorkloadIsDeterministic() {
+    WorkloadOptions options;
+    options.vocabulary_size = 1000U;
+    WorkloadGenerator first(options);
+    WorkloadGenerator second(options);
+    options.seed += 1U;
+    WorkloadGenerator other(options);
+
+    const auto kDocuments = first.GenerateDocuments(50U, 10);
+    const auto kSameDocuments = second.GenerateDocuments(50U, 10);
+    const auto kOtherDocuments = other.GenerateDocuments(50U, 10);
+    ASSERT_EQUAL(kDocuments.size(), 50U);
+    ASSERT_EQUAL(kDocuments.front().id, 10);
+    ASSERT_EQUAL(kDocuments.back().id, 59);
+    bool differs = false;
+    for (size_t i = 0U; i < kDocuments.size(); ++i) {
+        ASSERT_EQUAL(kDocuments[i].text, kSameDocuments[i].text);
+        ASSERT(kDocuments[i].status == kSameDocuments[i].status);
+        ASSERT_EQUAL(kDocuments[i].ratings, kSameDocuments[i].ratings);
+        differs = differs || kDocuments[i].text != kOtherDocuments[i].text;
+    }
+    ASSERT_HINT(differs, "another seed gives another corpus");
+    ASSERT_EQUAL(first.GenerateQueries(20U), second.GenerateQueries(20U));
+}
+
+// Pins the draw order, a length drawn in another order gives "da da da" and no ratings
+void TestWorkloadFirstDocumentIsPinned() {
+    WorkloadOptions options;
+    options.seed = 3U;
+    options.vocabulary_size = 10U;
+    options.min_document_length = 1U;
+    options.median_document_length = 4.0;
+    options.max_document_length = 8U;
+    options.max_rating_count = 3U;
+    WorkloadGenerator generator(options);
+
+    const GeneratedDocument kDocument = generator.GenerateDocument(1);
+    ASSERT_EQUAL(kDocument.text, "da da da ba fa"s);
+    ASSERT(kDocument.status == DocumentStatus::ACTUAL);
+    ASSERT_EQUAL(kDocument.ratings, (vector<int>{-5, -10, -5}));
+}
+
+void TestWorkloadWords() {
+    set<string> words;
+    for (size_t rank = 0U; rank < 20000U; ++rank) {
+        words.insert(WorkloadGenerator::MakeWord(rank));
+    }
+    ASSERT_EQUAL(words.size(), 20000U);
+    ASSERT(WorkloadGenerator::MakeWord(0U).size() <= WorkloadGenerator::MakeWord(19999U).size());
+
+    WorkloadOptions options;
+    options.vocabulary_size = 100U;
+    options.stop_word_count = 3U;
+    // stop words lie past the vocabulary and never collide with content words
+    ASSERT_EQUAL(WorkloadGenerator(options).GetStopWords(), WorkloadGenerator::MakeWord(100U) + ' ' +
+                                                            WorkloadGenerator::MakeWord(101U) + ' ' +
+                                                            WorkloadGenerator::MakeWord(102U));
+}
+
+void TestWorkloadDistributions() {
+    WorkloadOptions options;
+    options.vocabulary_size = 1000U;
+    options.zipf_exponent = 1.0;
+    options.stop_word_ratio = 0.2;
+    options.stop_word_count = 5U;
+    options.min_document_length = 10U;
+    options.max_document_length = 20U;
+    options.status_weights = {1.0, 0.0, 1.0, 0.0};
+    options.max_rating_count = 3U;
+    options.min_rating = 1;
+    options.max_rating = 2;
+    WorkloadGenerator generator(options);
+
+    const auto kStopWordList = SplitIntoWords(generator.GetStopWords());
+    const set<string> kStopWords(kStopWordList.begin(), kStopWordList.end());
+    map<string, size_t> word_counts;
+    size_t word_count = 0U;
+    size_t stop_word_count = 0U;
+    map<DocumentStatus, size_t> status_counts;
+    for (const auto &document: generator.GenerateDocuments(2000U)) {
+        const auto kWords = SplitIntoWords(document.text);
+        ASSERT(kWords.size() >= 10U && kWords.size() <= 20U);
+        for (const string &word: kWords) {
+            ++word_count;
+            kStopWords.count(word) ? ++stop_word_count : ++word_counts[word];
+        }
+        ++status_counts[document.status];
+        ASSERT(document.ratings.size() <= 3U);
+        for (const int kRating: document.ratings) {
+            ASSERT(kRating == 1 || kRating == 2);
+        }
+    }
+
+    const double kStopWordShare = static_cast<double>(stop_word_count) / static_cast<double>(word_count);
+    ASSERT_HINT(kStopWordShare > 0.17 && kStopWordShare < 0.23, "stop words follow the ratio");
+    ASSERT_EQUAL(status_counts.count(DocumentStatus::IRRELEVANT) + status_counts.count(DocumentStatus::REMOVED), 0U);
+    ASSERT(status_counts[DocumentStatus::ACTUAL] > 800U && status_counts[DocumentStatus::BANNED] > 800U);
+
+    // with exponent 1 the first word is about ten times as frequent as the tenth
+    const double kHeadRatio = static_cast<double>(word_counts[WorkloadGenerator::MakeWord(0U)]) /
+                              static_cast<double>(word_counts[WorkloadGenerator::MakeWord(9U)]);
+    ASSERT_HINT(kHeadRatio > 7.0 && kHeadRatio < 14.0, "word frequencies follow Zipf's law");
+}
+
+void TestWorkloadQueries() {
+    WorkloadOptions options;
+    options.vocabulary_size = 100U;
+    options.min_query_length = 2U;
+    options.max_query_length = 4U;
+    options.minus_word_ratio = 1.0;
+    WorkloadGenerator generator(options);
+
+    for (const string &query: generator.GenerateQueries(100U)) {
+        const auto kWords = SplitIntoWords(query);
+        ASSERT(kWords.size() >= 2U && kWords.size() <= 4U);
+        ASSERT(kWords.front()[0] != '-');
+        for (size_t i = 1U; i < kWords.size(); ++i) {
+            ASSERT(kWords[i][0] == '-');
+        }
+    }
+}
+
+void TestWorkloadOptionsValidation() {
+    const auto kCheckRejected = [](void (*change)(WorkloadOptions &)) {
+        WorkloadOptions options;
+        change(options);
+        CheckThrow<invalid_argument>([&options]() { WorkloadGenerator generator(options); });
+    };
+    kCheckRejected([](WorkloadOptions &options) { options.vocabulary_size = 0U; });
+    kCheckRejected([](WorkloadOptions &options) { options.zipf_exponent = -1.0; });
+    kCheckRejected([](WorkloadOptions &options) { options.min_document_length = 0U; });
+    kCheckRejected([](WorkloadOptions &options) { options.min_query_length = 5U; });
+    kCheckRejected([](WorkloadOptions &options) { options.stop_word_ratio = 1.5; });
+    kCheckRejected([](WorkloadOptions &options) { options.minus_word_ratio = -0.5; });
+    kCheckRejected([](WorkloadOptions &options) { options.stop_word_count = 0U; });
+    kCheckRejected([](WorkloadOptions &options) { options.status_weights = {0.0, 0.0, 0.0, 0.0}; });
+    kCheckRejected([](WorkloadOptions &options) { options.min_rating = 1; options.max_rating = 0; });
+}
+
+void TestWorkloadFullRatingRange() {
+    WorkloadOptions options;
+    options.vocabulary_size = 100U;
+    options.max_rating_count = 10U;
+    options.min_rating = numeric_limits<int>::min();
+    options.max_rating = numeric_limits<int>::max();
+    WorkloadGenerator generator(options);
+
+    bool has_negative = false;
+    bool has_positive = false;
+    for (const auto &document: generator.GenerateDocuments(100U)) {
+        for (const int kRating: document.ratings) {
+            has_negative = has_negative || kRating < 0;
+            has_positive = has_positive || kRating > 0;
+        }
+    }
+    ASSERT_HINT(has_negative && has_positive, "ratings cover the whole range");
+
+    options.min_rating = 7;
+    options.max_rating = 7;
+    for (const auto &document: WorkloadGenerator(options).GenerateDocuments(20U)) {
+        ASSERT_EQUAL(document.ratings, vector<int>(document.ratings.size(), 7));
+    }
+}
+
+// Pages over a generated corpus are disjoint, ordered and hold only matching documents
+void TestWorkloadSearchStress() {
+    WorkloadOptions options;
+    options.vocabulary_size = 2000U;
+    options.minus_word_ratio = 0.3;
+    options.max_query_length = 5U;
+    WorkloadGenerator generator(options);
+
+    SearchServer server(generator.GetStopWords());
+    for (const auto &document: generator.GenerateDocuments(1000U)) {
+        server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+
+    for (const string &query: generator.GenerateQueries(200U)) {
+        const auto kAllAtOnce = server.FindTopDocumentsPage(query, 1000U).documents;
+        set<int> seen;
+        vector<Document> found;
+        string token;
+        do {
+            auto page = server.FindTopDocumentsPage(query, 7U, token);
+            found.insert(found.end(), page.documents.begin(), page.documents.end());
+            token = move(page.continuation_token);
+        } while (!token.empty());
+        ASSERT_EQUAL(found.size(), kAllAtOnce.size());
+
+        for (size_t i = 0U; i < found.size(); ++i) {
+            ASSERT_HINT(seen.insert(found[i].id).second, "pages are disjoint");
+            const auto [kWords, kStatus] = server.MatchDocument(query, found[i].id);
+            ASSERT(!kWords.empty());
+            ASSERT(kStatus == DocumentStatus::ACTUAL);
+            ASSERT(i == 0U || found[i - 1U].relevance >= found[i].relevance);
+            ASSERT_HINT(found[i].id == kAllAtOnce[i].id, "pages follow the order of a single page");
+        }
+
+        const auto kTop = server.FindTopDocuments(query);
+        ASSERT_EQUAL(kTop.size(), min(found.size(), server.kMaxResultDocumentSize));
+    }
+}
+
+void TestWorkloadGenerator() {
+    RUN_TEST(TestWorkloadIsDeterministic);
+    RUN_TEST(TestWorkloadFirstDocumentIsPinned);
+    RUN_TEST(TestWorkloadWords);
+    RUN_TEST(TestWorkloadDistributions);
+    RUN_TEST(TestWorkloadQueries);
+    RUN_TEST(TestWorkloadOptionsValidation);
+    RUN_TEST(TestWorkloadFullRatingRange);
+    RUN_TEST(TestWorkloadSearchStress);
+    std::cerr << std::endl;
+}
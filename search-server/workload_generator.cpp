@@ -0,0 +1,177 @@
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+
+namespace {
+
+const char kConsonants[] = "bdfgklmnprstvz";
+const char kVowels[] = "aeiou";
+const size_t kConsonantCount = sizeof(kConsonants) - 1U;
+const size_t kSyllableCount = kConsonantCount * (sizeof(kVowels) - 1U);
+const double kPi = 3.14159265358979323846;
+
+void CheckRatio(double ratio, const std::string &name) {
+    if (!(ratio >= 0.0 && ratio <= 1.0)) {
+        throw std::invalid_argument(name + " must be in [0, 1]");
+    }
+}
+
+const WorkloadOptions &CheckOptions(const WorkloadOptions &options) {
+    if (options.vocabulary_size == 0U) {
+        throw std::invalid_argument("vocabulary must not be empty");
+    }
+    if (options.min_document_length == 0U || options.min_document_length > options.max_document_length) {
+        throw std::invalid_argument("document lengths must satisfy 0 < min <= max");
+    }
+    if (options.min_query_length == 0U || options.min_query_length > options.max_query_length) {
+        throw std::invalid_argument("query lengths must satisfy 0 < min <= max");
+    }
+    if (options.min_rating > options.max_rating) {
+        throw std::invalid_argument("ratings must satisfy min <= max");
+    }
+    if (options.zipf_exponent < 0.0 || options.median_document_length <= 0.0 || options.document_length_sigma < 0.0) {
+        throw std::invalid_argument("zipf exponent, median document length and sigma must not be negative");
+    }
+    CheckRatio(options.stop_word_ratio, "stop word ratio");
+    CheckRatio(options.minus_word_ratio, "minus word ratio");
+    if (options.stop_word_ratio > 0.0 && options.stop_word_count == 0U) {
+        throw std::invalid_argument("stop words are drawn, but there are none");
+    }
+    if (std::any_of(options.status_weights.begin(), options.status_weights.end(),
+                    [](double weight) { return weight < 0.0; }) ||
+        std::accumulate(options.status_weights.begin(), options.status_weights.end(), 0.0) <= 0.0) {
+        throw std::invalid_argument("status weights must be non-negative with a positive sum");
+    }
+    return options;
+}
+
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadOptions &options)
+        : options_(CheckOptions(options)), generator_(options_.seed) {
+    zipf_distribution_.reserve(options_.vocabulary_size);
+    double cumulative_weight = 0.0;
+    for (size_t rank = 0U; rank < options_.vocabulary_size; ++rank) {
+        cumulative_weight += 1.0 / std::pow(static_cast<double>(rank + 1U), options_.zipf_exponent);
+        zipf_distribution_.push_back(cumulative_weight);
+    }
+    for (double &probability: zipf_distribution_) {
+        probability /= cumulative_weight;
+    }
+
+    // ranks past the vocabulary never collide with content words
+    for (size_t i = 0U; i < options_.stop_word_count; ++i) {
+        stop_words_.push_back(MakeWord(options_.vocabulary_size + i));
+    }
+}
+
+std::string WorkloadGenerator::GetStopWords() const {
+    std::string text;
+    for (const std::string &word: stop_words_) {
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += word;
+    }
+    return text;
+}
+
+std::string WorkloadGenerator::MakeWord(size_t rank) {
+    // bijective base-kSyllableCount numeral, so every rank has its own word
+    std::string word;
+    for (size_t value = rank + 1U; value > 0U; value = (value - 1U) / kSyllableCount) {
+        const size_t kSyllable = (value - 1U) % kSyllableCount;
+        word += kConsonants[kSyllable % kConsonantCount];
+        word += kVowels[kSyllable / kConsonantCount];
+    }
+    return word;
+}
+
+GeneratedDocument WorkloadGenerator::GenerateDocument(int id) {
+    GeneratedDocument document{id, {}, DocumentStatus::ACTUAL, {}};
+
+    // Box-Muller over two uniforms, std::normal_distribution differs between standard libraries. The draws are
+    // named so that their order does not depend on how the compiler sequences the operands.
+    const double kRadiusUnit = GenerateUnit();
+    const double kAngleUnit = GenerateUnit();
+    const double kNormal = std::sqrt(-2.0 * std::log(1.0 - kRadiusUnit)) * std::cos(2.0 * kPi * kAngleUnit);
+    const double kLength = options_.median_document_length * std::exp(options_.document_length_sigma * kNormal);
+    const size_t kWordCount = std::clamp(static_cast<size_t>(std::llround(kLength)), options_.min_document_length,
+                                         options_.max_document_length);
+    for (size_t i = 0U; i < kWordCount; ++i) {
+        if (i > 0U) {
+            document.text += ' ';
+        }
+        document.text += GenerateUnit() < options_.stop_word_ratio
+                         ? stop_words_[GenerateIndex(0U, stop_words_.size() - 1U)]
+                         : MakeWord(GenerateZipfRank());
+    }
+
+    const double kStatusPoint = GenerateUnit() *
+                                std::accumulate(options_.status_weights.begin(), options_.status_weights.end(), 0.0);
+    double cumulative_weight = 0.0;
+    for (size_t status = 0U; status < options_.status_weights.size(); ++status) {
+        cumulative_weight += options_.status_weights[status];
+        if (kStatusPoint < cumulative_weight) {
+            document.status = static_cast<DocumentStatus>(status);
+            break;
+        }
+    }
+
+    const size_t kRatingCount = GenerateIndex(0U, options_.max_rating_count);
+    // the range of two ints may not fit into an int
+    const auto kRatingRange = static_cast<size_t>(static_cast<int64_t>(options_.max_rating) - options_.min_rating);
+    for (size_t i = 0U; i < kRatingCount; ++i) {
+        document.ratings.push_back(static_cast<int>(options_.min_rating +
+                                                    static_cast<int64_t>(GenerateIndex(0U, kRatingRange))));
+    }
+    return document;
+}
+
+std::vector<GeneratedDocument> WorkloadGenerator::GenerateDocuments(size_t count, int first_id) {
+    std::vector<GeneratedDocument> documents;
+    documents.reserve(count);
+    for (size_t i = 0U; i < count; ++i) {
+        documents.push_back(GenerateDocument(first_id + static_cast<int>(i)));
+    }
+    return documents;
+}
+
+std::string WorkloadGenerator::GenerateQuery() {
+    std::string query;
+    for (size_t i = GenerateIndex(options_.min_query_length, options_.max_query_length); i > 0U; --i) {
+        if (!query.empty()) {
+            query += GenerateUnit() < options_.minus_word_ratio ? " -" : " ";
+        }
+        query += MakeWord(GenerateZipfRank());
+    }
+    return query;
+}
+
+std::vector<std::string> WorkloadGenerator::GenerateQueries(size_t count) {
+    std::vector<std::string> queries;
+    queries.reserve(count);
+    for (size_t i = 0U; i < count; ++i) {
+        queries.push_back(GenerateQuery());
+    }
+    return queries;
+}
+
+double WorkloadGenerator::GenerateUnit() {
+    // the top 53 bits fill the mantissa of a double exactly
+    return static_cast<double>(generator_() >> 11U) * 0x1.0p-53;
+}
+
+size_t WorkloadGenerator::GenerateIndex(size_t first, size_t last) {
+    const auto kOffset = static_cast<size_t>(GenerateUnit() * static_cast<double>(last - first + 1U));
+    return first + std::min(kOffset, last - first);
+}
+
+size_t WorkloadGenerator::GenerateZipfRank() {
+    const auto kIt = std::upper_bound(zipf_distribution_.begin(), zipf_distribution_.end(), GenerateUnit());
+    return std::min(static_cast<size_t>(kIt - zipf_distribution_.begin()), zipf_distribution_.size() - 1U);
+}
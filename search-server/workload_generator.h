@@ -0,0 +1,89 @@
+#pragma once
+
+#include "document.h"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct WorkloadOptions {
+    uint64_t seed = 42U;
+
+    // content words, the word of rank r is drawn with probability proportional to 1 / (r + 1) ^ zipf_exponent
+    size_t vocabulary_size = 50000U;
+    double zipf_exponent = 1.0;
+
+    // document lengths in words follow a log-normal distribution clipped to [min, max]
+    size_t min_document_length = 5U;
+    size_t max_document_length = 200U;
+    double median_document_length = 30.0;
+    double document_length_sigma = 0.6;
+
+    // every document word is a stop word with this probability, drawn uniformly from stop_word_count of them
+    double stop_word_ratio = 0.1;
+    size_t stop_word_count = 20U;
+
+    // query lengths are uniform, every word but the first is a minus word with minus_word_ratio probability
+    size_t min_query_length = 1U;
+    size_t max_query_length = 4U;
+    double minus_word_ratio = 0.1;
+
+    // relative weights of ACTUAL, IRRELEVANT, BANNED and REMOVED
+    std::array<double, 4> status_weights = {0.85, 0.05, 0.05, 0.05};
+
+    // every document gets a uniform number of ratings in [0, max_rating_count], each uniform in [min, max]
+    size_t max_rating_count = 5U;
+    int min_rating = -10;
+    int max_rating = 10;
+};
+
+struct GeneratedDocument {
+    int id;
+    std::string text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+// Deterministic synthetic corpus and query stream with a Zipfian word distribution. Randomness comes only from
+// std::mt19937_64, whose output is fixed by the standard, so a seed always gives the same workload on one platform.
+// Word ranks and document lengths go through pow, log, exp and cos, which math libraries need not round alike,
+// so another platform may draw a few different words and lengths from the same seed.
+// Words are pronounceable and get longer with rank, as in real text.
+class WorkloadGenerator {
+public:
+    explicit WorkloadGenerator(const WorkloadOptions &options);
+
+public:
+    // Space separated, as SearchServer takes them
+    std::string GetStopWords() const;
+
+    // Content word of the given frequency rank, 0 is the most frequent
+    static std::string MakeWord(size_t rank);
+
+    GeneratedDocument GenerateDocument(int id);
+
+    // Ids are first_id, first_id + 1, ...
+    std::vector<GeneratedDocument> GenerateDocuments(size_t count, int first_id = 0);
+
+    std::string GenerateQuery();
+
+    std::vector<std::string> GenerateQueries(size_t count);
+
+private:
+    // Uniform in [0, 1)
+    double GenerateUnit();
+
+    // Uniform in [first, last]
+    size_t GenerateIndex(size_t first, size_t last);
+
+    size_t GenerateZipfRank();
+
+private:
+    const WorkloadOptions options_;
+    std::mt19937_64 generator_;
+    // cumulative probabilities of the ranks
+    std::vector<double> zipf_distribution_;
+    std::vector<std::string> stop_words_;
+};